@@ -5,63 +5,96 @@
 #include <stdlib.h>
 
 #include "avltree.h"
+#include "dsstat.h"
 #include "exception.h"
 
 #define metaof(avl) ((avl_meta*)avl->reserved)
 #define heightof(n) ((n)?entryof((n))->height:0)
+#define key_cmp(meta, a, b) ds_stat_cmp(DS_STAT_AVLTREE, (meta)->cmp, a, b)
+#define AGGR_ALIGN 8
 
-bintree* avl_create_(size_t szkey, size_t szval, avl_cmp cmp)
+bintree* avl_create_aggr_(size_t szkey, size_t szval, avl_cmp cmp,
+        avl_aggr const * aggr)
 {
-    bintree* avl = bt_create_(sizeof(avl_entry) + szkey + szval, NULL);
+    size_t aggr_offset = sizeof(avl_entry) + szkey + szval;
+    aggr_offset = (aggr_offset + AGGR_ALIGN - 1) / AGGR_ALIGN * AGGR_ALIGN;
+
+    bintree* avl = bt_create_(aggr ? aggr_offset + aggr->size :
+            sizeof(avl_entry) + szkey + szval, NULL);
 
     avl->reserved = malloc(sizeof(avl_meta));
     if(!avl->reserved) toss(MemoryError);
     metaof(avl)->key_size = szkey;
     metaof(avl)->val_size = szval;
     metaof(avl)->cmp = cmp;
+    if(aggr) metaof(avl)->aggr = *aggr;
+    else memset(&metaof(avl)->aggr, 0, sizeof(avl_aggr));
+    metaof(avl)->aggr_offset = aggr_offset;
+    pthread_rwlock_init(&metaof(avl)->lock, NULL);
 
     return avl;
 }
 
+bintree* avl_create_(size_t szkey, size_t szval, avl_cmp cmp)
+{ return avl_create_aggr_(szkey, szval, cmp, NULL); }
+
+// refresh height, size and aggregate of n from its children
+static void avl_update_(bintree* bt, btnode* n)
+{
+    avl_meta* meta = metaof(bt);
+    avl_entry* e = entryof(n);
+    int hl = heightof(n->left),
+        hr = heightof(n->right);
+
+    e->height = (hl > hr ? hl : hr) + 1;
+    e->size = avl_subtree_size(n->left) + 1 + avl_subtree_size(n->right);
+
+    if(!e->aggr) return;
+
+    uint8_t self[meta->aggr.size];
+    meta->aggr.init(self, e->key, e->val);
+    if(n->left) {
+        memcpy(e->aggr, entryof(n->left)->aggr, meta->aggr.size);
+        meta->aggr.merge(e->aggr, self);
+    } else memcpy(e->aggr, self, meta->aggr.size);
+    if(n->right) meta->aggr.merge(e->aggr, entryof(n->right)->aggr);
+}
+
 static btnode* avl_new_node_(bintree* bt,
         void const * key, void const * val)
 {
-    avl_entry empty_entry = { NULL, NULL, 1 };
+    avl_entry empty_entry = { NULL, NULL, 1, 1, NULL };
 
     avl_meta* meta = metaof(bt);
     btnode* new_node = bt_new_node(bt, NULL);
     empty_entry.key = new_node->data + sizeof(avl_entry);
     empty_entry.val = new_node->data + sizeof(avl_entry) + metaof(bt)->key_size;
+    if(meta->aggr.size)
+        empty_entry.aggr = new_node->data + meta->aggr_offset;
 
     memcpy(new_node->data, &empty_entry, sizeof(empty_entry));
     memcpy(entryof(new_node)->key, key, meta->key_size);
     memcpy(entryof(new_node)->val, val, meta->val_size);
+    if(empty_entry.aggr) meta->aggr.init(empty_entry.aggr, key, val);
 
     return new_node;
 }
 
-static void avl_update_height_(btnode* n)
-{
-    int hl = heightof(n->left),
-        hr = heightof(n->right);
-
-    entryof(n)->height = (hl > hr ? hl : hr) + 1;
-}
-
 // avl_*rotate rotates node `n`, and return the node that replaces `n`
 static btnode* avl_lrotate_(bintree* bt, btnode* n)
 {
     btnode* rnode = n->right;
     if(!rnode) toss(ExcessiveRotation);
+    ds_stat_inc(DS_STAT_AVLTREE, DS_STAT_ROTATIONS);
 
     bt_rchild(n, rnode->left);
-    avl_update_height_(n);
+    avl_update_(bt, n);
 
     rnode->parent = n->parent;
     bt_pfield(bt, n->parent, n) = rnode;
 
     bt_lchild(rnode, n);
-    avl_update_height_(rnode);
+    avl_update_(bt, rnode);
 
     return rnode;
 }
@@ -70,15 +103,16 @@ static btnode* avl_rrotate_(bintree* bt, btnode* n)
 {
     btnode* lnode = n->left;
     if(!lnode) toss(ExcessiveRotation);
+    ds_stat_inc(DS_STAT_AVLTREE, DS_STAT_ROTATIONS);
 
     bt_lchild(n, lnode->right);
-    avl_update_height_(n);
+    avl_update_(bt, n);
 
     lnode->parent = n->parent;
     bt_pfield(bt, n->parent, n) = lnode;
 
     bt_rchild(lnode, n);
-    avl_update_height_(lnode);
+    avl_update_(bt, lnode);
 
     return lnode;
 }
@@ -110,46 +144,64 @@ static btnode* avl_rebalance_(bintree* bt, btnode* n)
         subs = avl_lrotate_(bt, n);
     } else if(abs(hr - hl) > 2) {
         toss(LoseBalance);
-    } else avl_update_height_(n);
+    } else avl_update_(bt, n);
 
     return subs;
 }
 
-static btnode* avl_set_branch_(bintree* bt, btnode* n /* not null */,
-        void const * key, void const * value)
+btnode* avl_set(bintree* bt, void const * key, void const * value)
 {
-    avl_entry* entry = entryof(n);
     avl_meta* meta = metaof(bt);
-    btnode* result = NULL;
-
-    int cmp = meta->cmp(key, entry->key);
-    if(cmp == 0) {
-        memcpy(entry->val, value, meta->val_size);
-        return n;
-    } else if(cmp < 0) {
-        if(!n->left)
-            result = bt_lchild(n, avl_new_node_(bt, key, value));
-        else
-            result = avl_set_branch_(bt, n->left, key, value);
-    } else if(cmp > 0) {
-        if(!n->right)
-            result = bt_rchild(n, avl_new_node_(bt, key, value));
-        else
-            result = avl_set_branch_(bt, n->right, key, value);
-    }
-
-    avl_rebalance_(bt, n);
-    return result;
-}
 
-btnode* avl_set(bintree* bt, void const * key, void const * value)
-{
     if(!bt->root) {
         bt->root = avl_new_node_(bt, key, value);
         return bt->root;
     }
 
-    return avl_set_branch_(bt, bt->root, key, value);
+    // a path from the root is never longer than the root's height
+    btnode* path[entryof(bt->root)->height];
+    size_t depth = 0;
+    btnode* n = bt->root;
+    int cmp;
+
+    while(1) {
+        cmp = key_cmp(meta, key, entryof(n)->key);
+        if(cmp == 0) {
+            if(!value) return n;
+            memcpy(entryof(n)->val, value, meta->val_size);
+            if(!meta->aggr.size) return n;
+
+            // the structure stays, only the aggregates on the path change
+            avl_update_(bt, n);
+            while(depth--) avl_update_(bt, path[depth]);
+            return n;
+        }
+
+        path[depth++] = n;
+        btnode* next = cmp < 0 ? n->left : n->right;
+        if(!next) break;
+        n = next;
+    }
+
+    btnode* result = avl_new_node_(bt, key, value);
+    if(cmp < 0) bt_lchild(n, result);
+    else bt_rchild(n, result);
+
+    // once a sub-tree gets back its former height, ancestors need no more
+    // rotations, but their sizes and aggregates still change
+    int balanced = 0;
+    while(depth--) {
+        if(balanced) {
+            avl_update_(bt, path[depth]);
+            continue;
+        }
+
+        int height = entryof(path[depth])->height;
+        btnode* subs = avl_rebalance_(bt, path[depth]);
+        balanced = entryof(subs)->height == height;
+    }
+
+    return result;
 }
 
 void* avl_get(bintree* bt, void const * key, btnode** node)
@@ -158,7 +210,7 @@ void* avl_get(bintree* bt, void const * key, btnode** node)
     avl_meta* meta = metaof(bt);
 
     while(cur_node) {
-        int cmp = meta->cmp(key, entryof(cur_node)->key);
+        int cmp = key_cmp(meta, key, entryof(cur_node)->key);
         if(cmp == 0)
             break;
         else if(cmp < 0)
@@ -174,11 +226,51 @@ void* avl_get(bintree* bt, void const * key, btnode** node)
 }
 
 void avl_unset(bintree* bt, void const * key)
+{
+    if(avl_try_unset(bt, key) != DS_OK) toss(KeyNotFound);
+}
+
+ds_error avl_try_get(bintree* bt, void const * key, void** value)
+{
+    *value = avl_get(bt, key, NULL);
+    return *value ? DS_OK : DS_KEY_NOT_FOUND;
+}
+
+ds_error avl_try_unset(bintree* bt, void const * key)
 {
     btnode* n;
     avl_get(bt, key, &n);
-    if(n) avl_unset_node(bt, n);
-    else toss(KeyNotFound);
+    if(!n) return DS_KEY_NOT_FOUND;
+    avl_unset_node(bt, n);
+    return DS_OK;
+}
+
+int avl_get_ts(bintree* bt, void const * key, void* value)
+{
+    avl_meta* meta = metaof(bt);
+
+    pthread_rwlock_rdlock(&meta->lock);
+    void* val = avl_get(bt, key, NULL);
+    if(val) memcpy(value, val, meta->val_size);
+    pthread_rwlock_unlock(&meta->lock);
+
+    return val != NULL;
+}
+
+void avl_set_ts(bintree* bt, void const * key, void const * value)
+{
+    pthread_rwlock_wrlock(&metaof(bt)->lock);
+    avl_set(bt, key, value);
+    pthread_rwlock_unlock(&metaof(bt)->lock);
+}
+
+int avl_unset_ts(bintree* bt, void const * key)
+{
+    pthread_rwlock_wrlock(&metaof(bt)->lock);
+    int found = avl_try_unset(bt, key) == DS_OK;
+    pthread_rwlock_unlock(&metaof(bt)->lock);
+
+    return found;
 }
 
 #define avl_swap_node_p_(p1, p2) { btnode* t = p1; p1 = p2; p2 = t; }
@@ -231,10 +323,13 @@ void avl_unset_node(bintree* bt, btnode* n)
     }
 
     if(n != cur_node) {
-        // note: don't swap height
+        // note: don't swap height and size, which belong to the position
         int h = entryof(n)->height;
         entryof(n)->height = entryof(cur_node)->height;
         entryof(cur_node)->height = h;
+        size_t sz = entryof(n)->size;
+        entryof(n)->size = entryof(cur_node)->size;
+        entryof(cur_node)->size = sz;
 
         avl_swap_node(bt, cur_node, n);
     }
@@ -242,9 +337,143 @@ void avl_unset_node(bintree* bt, btnode* n)
     avl_unset_node(bt, n);
 }
 
+static btnode* avl_build_range_(bintree* bt, varray* sorted,
+        size_t begin, size_t end)
+{
+    if(begin >= end) return NULL;
+
+    size_t mid = begin + (end - begin) / 2;
+    uint8_t* e = va_at(sorted, mid);
+    btnode* n = avl_new_node_(bt, e, e + metaof(bt)->key_size);
+
+    bt_lchild(n, avl_build_range_(bt, sorted, begin, mid));
+    bt_rchild(n, avl_build_range_(bt, sorted, mid + 1, end));
+    avl_update_(bt, n);
+
+    return n;
+}
+
+void avl_build_sorted(bintree* bt, varray* sorted)
+{
+    avl_meta* meta = metaof(bt);
+
+    if(bt->root) toss(NotEmpty);
+    if((size_t)sorted->elem_size != meta->key_size + meta->val_size)
+        toss(InvalidElemSize);
+    for(size_t i = 1; i < sorted->length; i++)
+        if(key_cmp(meta, va_at(sorted, i - 1), va_at(sorted, i)) >= 0)
+            toss(UnsortedInput);
+
+    bt->root = avl_build_range_(bt, sorted, 0, sorted->length);
+}
+
 void avl_destroy(bintree* bt)
 {
-    if(bt->reserved) free(bt->reserved);
+    if(bt->reserved) {
+        pthread_rwlock_destroy(&metaof(bt)->lock);
+        free(bt->reserved);
+    }
     bt_destroy(bt);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Order Statistics
+
+size_t avl_rank(bintree* bt, void const * key)
+{
+    avl_meta* meta = metaof(bt);
+    size_t rank = 0;
+
+    for(btnode* n = bt->root; n; ) {
+        if(key_cmp(meta, entryof(n)->key, key) < 0) {
+            rank += avl_subtree_size(n->left) + 1;
+            n = n->right;
+        } else n = n->left;
+    }
+
+    return rank;
+}
+
+btnode* avl_select(bintree* bt, size_t i)
+{
+    btnode* n = bt->root;
+
+    while(n) {
+        size_t left = avl_subtree_size(n->left);
+        if(i == left) break;
+        if(i < left) n = n->left;
+        else {
+            i -= left + 1;
+            n = n->right;
+        }
+    }
+
+    return n;
+}
+
+// fold pieces into result in key order, where count is the number of entries
+// folded so far, and the aggregate is skipped if the tree has none
+static size_t avl_fold_entry_(avl_meta* meta, void* result, size_t count,
+        btnode* n)
+{
+    if(!meta->aggr.size) return count + 1;
+
+    uint8_t self[meta->aggr.size];
+    meta->aggr.init(self, entryof(n)->key, entryof(n)->val);
+    if(count) meta->aggr.merge(result, self);
+    else memcpy(result, self, meta->aggr.size);
+
+    return count + 1;
+}
+
+static size_t avl_fold_subtree_(avl_meta* meta, void* result, size_t count,
+        btnode* n)
+{
+    if(!n) return count;
+    if(!meta->aggr.size) return count + entryof(n)->size;
+
+    if(count) meta->aggr.merge(result, entryof(n)->aggr);
+    else memcpy(result, entryof(n)->aggr, meta->aggr.size);
+
+    return count + entryof(n)->size;
+}
+
+size_t avl_range_aggr(bintree* bt, void const * begin, void const * end,
+        void* result)
+{
+    avl_meta* meta = metaof(bt);
+    btnode* split = bt->root;
+
+    // the highest node in range, below which the bounds take separate paths
+    while(split) {
+        if(key_cmp(meta, entryof(split)->key, begin) < 0) split = split->right;
+        else if(key_cmp(meta, entryof(split)->key, end) >= 0) split = split->left;
+        else break;
+    }
+    if(!split) return 0;
+
+    // on the left path, pieces are found from right to left
+    btnode* pieces[entryof(split)->height];
+    size_t npieces = 0, count = 0;
+    for(btnode* n = split->left; n; ) {
+        if(key_cmp(meta, entryof(n)->key, begin) >= 0) {
+            pieces[npieces++] = n;
+            n = n->left;
+        } else n = n->right;
+    }
+
+    while(npieces--) {
+        count = avl_fold_entry_(meta, result, count, pieces[npieces]);
+        count = avl_fold_subtree_(meta, result, count, pieces[npieces]->right);
+    }
+    count = avl_fold_entry_(meta, result, count, split);
+    for(btnode* n = split->right; n; ) {
+        if(key_cmp(meta, entryof(n)->key, end) < 0) {
+            count = avl_fold_subtree_(meta, result, count, n->left);
+            count = avl_fold_entry_(meta, result, count, n);
+            n = n->right;
+        } else n = n->left;
+    }
+
+    return count;
+}
@@ -7,8 +7,10 @@
 
 #include "bintree.h"
 #include "utils.h"
+#include "varray.h"
 
 #include <string.h>
+#include <pthread.h>
 
 typedef comparator avl_cmp;
 
@@ -16,25 +18,74 @@ typedef struct avl_entry_t_ {
     uint8_t* key;
     uint8_t* val;
     int height; // distance to the furthest leaf, not root
+    size_t size; // number of entries in the sub-tree
+    uint8_t* aggr; // aggregate of the sub-tree, NULL without avl_aggr
 } avl_entry;
 
+/*
+ * An aggregate summarizes the entries of every sub-tree, such as the sum or
+ * the maximum of values, and is kept up to date through insertion, removal
+ * and rotations. `init` makes the aggregate of a single entry, and `merge`
+ * folds `right`, which covers keys all after those of `aggr`, into `aggr`.
+ * Merging has to be associative, but needn't be commutative.
+ * Values must be modified by avl_set rather than in place, or aggregates of
+ * the ancestors go stale.
+ */
+typedef struct avl_aggr_t_ {
+    size_t size;
+    void (*init) (void* aggr, void const * key, void const * val);
+    void (*merge) (void* aggr, void const * right);
+} avl_aggr;
+
 typedef struct avl_meta_t_ {
     size_t key_size;
     size_t val_size;
     avl_cmp cmp;
+    avl_aggr aggr; // zero size without aggregates
+    size_t aggr_offset; // from the start of avl_entry
+    pthread_rwlock_t lock; // taken by the _ts variants only
 } avl_meta;
 
 bintree* avl_create_(size_t szkey, size_t szval, avl_cmp cmp);
+bintree* avl_create_aggr_(size_t szkey, size_t szval, avl_cmp cmp,
+        avl_aggr const * aggr);
 // insert node or update it while key exists
 // data will not change if value is null
 btnode* avl_set(bintree* bt, void const * key, void const * value);
 void* avl_get(bintree* bt, void const * key, btnode** node);
 void avl_unset_node(bintree* bt, btnode* n);
 void avl_unset(bintree* bt, void const * key);
+// error code variants, see exception.h
+ds_error avl_try_get(bintree* bt, void const * key, void** value);
+ds_error avl_try_unset(bintree* bt, void const * key);
 void avl_destroy(bintree* bt);
+// build a perfectly balanced tree in O(n) from `sorted`, whose elements are
+// keys immediately followed by values, in strictly increasing order of keys.
+// The tree must be empty.
+void avl_build_sorted(bintree* bt, varray* sorted);
+
+// Order statistics, in O(log n): avl_rank counts keys less than `key`, and
+// avl_select finds the entry of rank i, or NULL if i >= the number of entries.
+size_t avl_rank(bintree* bt, void const * key);
+btnode* avl_select(bintree* bt, size_t i);
+// Count entries with keys in [begin, end) and, if the tree has aggregates and
+// the range isn't empty, write their aggregate into `result`, in O(log n).
+size_t avl_range_aggr(bintree* bt, void const * begin, void const * end,
+        void* result);
+
+// Thread-safe variants: readers share the tree while writers hold it alone.
+// Since a node may be freed as soon as the lock is released, avl_get_ts
+// copies the value into `value` instead of returning a pointer. Both
+// avl_get_ts and avl_unset_ts return whether the key was found.
+int avl_get_ts(bintree* bt, void const * key, void* value);
+void avl_set_ts(bintree* bt, void const * key, void const * value);
+int avl_unset_ts(bintree* bt, void const * key);
 
 #define entryof(n) ((avl_entry*)n->data)
 #define avl_create(ktype, vtype, kcmp) \
     avl_create_(sizeof(ktype), sizeof(vtype), kcmp);
+#define avl_create_aggr(ktype, vtype, kcmp, aggr) \
+    avl_create_aggr_(sizeof(ktype), sizeof(vtype), kcmp, aggr);
+#define avl_subtree_size(n) ((n) ? entryof(n)->size : 0)
 
 #endif // AVLTREE_H_INCLUDED
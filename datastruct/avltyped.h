@@ -0,0 +1,190 @@
+/*
+ * Copyright(c) 2015, Shihira Fung <fengzhiping@hotmail.com>
+ */
+
+#ifndef AVLTYPED_H_INCLUDED
+#define AVLTYPED_H_INCLUDED
+
+#include <stdlib.h>
+
+#include "exception.h"
+#include "mempool.h"
+#include "utils.h"
+
+/*
+ * AVL_DEFINE(name, ktype, vtype, cmp) generates an AVL map specialized for
+ * the key and value types: the struct `name` and static inline functions
+ * name_create, name_destroy, name_get, name_set and name_unset. Keys and values
+ * are held in nodes by value, and cmp compares two keys by value like cmp_num.
+ * It's the counterpart of avltree without aggregates, order statistics or
+ * locking, meant for hot paths where memcpy and calls through a comparator
+ * pointer would dominate. Nodes come from a mempool as in bintree.
+ *
+ *     AVL_DEFINE(avl_int_int, int, int, cmp_num)
+ *     avl_int_int* t = avl_int_int_create();
+ *     avl_int_int_set(t, 1, 100);
+ *     int* v = avl_int_int_get(t, 1);
+ */
+
+// an AVL tree of height 96 has more than 2^64 nodes
+#define AVL_TYPED_MAX_HEIGHT 96
+
+#define AVL_DEFINE(name, ktype, vtype, cmp) \
+\
+typedef struct name##_node_t_ { \
+    ktype key; \
+    vtype val; \
+    int height; /* 1 for leaves */ \
+    struct name##_node_t_* left; \
+    struct name##_node_t_* right; \
+} name##_node; \
+\
+typedef struct name##_t_ { \
+    name##_node* root; \
+    size_t length; \
+    mempool* pool; \
+} name; \
+\
+static inline name* name##_create(void) \
+{ \
+    name* t = (name*)malloc(sizeof(name)); \
+    if(!t) toss(MemoryError); \
+    t->root = NULL; \
+    t->length = 0; \
+    t->pool = mp_create(sizeof(name##_node)); \
+    return t; \
+} \
+\
+static inline void name##_destroy(name* t) \
+{ \
+    mp_destroy(t->pool); \
+    free(t); \
+} \
+\
+static inline int name##_height_(name##_node* n) \
+{ return n ? n->height : 0; } \
+\
+static inline void name##_update_(name##_node* n) \
+{ \
+    int l = name##_height_(n->left), r = name##_height_(n->right); \
+    n->height = (l > r ? l : r) + 1; \
+} \
+\
+static inline name##_node* name##_rotate_left_(name##_node* n) \
+{ \
+    name##_node* r = n->right; \
+    n->right = r->left; \
+    r->left = n; \
+    name##_update_(n); \
+    name##_update_(r); \
+    return r; \
+} \
+\
+static inline name##_node* name##_rotate_right_(name##_node* n) \
+{ \
+    name##_node* l = n->left; \
+    n->left = l->right; \
+    l->right = n; \
+    name##_update_(n); \
+    name##_update_(l); \
+    return l; \
+} \
+\
+/* returns the new root of the sub-tree */ \
+static inline name##_node* name##_balance_(name##_node* n) \
+{ \
+    int d = name##_height_(n->left) - name##_height_(n->right); \
+    if(d > 1) { \
+        if(name##_height_(n->left->left) < name##_height_(n->left->right)) \
+            n->left = name##_rotate_left_(n->left); \
+        return name##_rotate_right_(n); \
+    } \
+    if(d < -1) { \
+        if(name##_height_(n->right->right) < name##_height_(n->right->left)) \
+            n->right = name##_rotate_right_(n->right); \
+        return name##_rotate_left_(n); \
+    } \
+    name##_update_(n); \
+    return n; \
+} \
+\
+static inline vtype* name##_get(name* t, ktype key) \
+{ \
+    for(name##_node* n = t->root; n; ) { \
+        int c = cmp(key, n->key); \
+        if(c == 0) return &n->val; \
+        n = c < 0 ? n->left : n->right; \
+    } \
+    return NULL; \
+} \
+\
+static inline void name##_set(name* t, ktype key, vtype val) \
+{ \
+    /* links to the nodes passed by, rebalanced bottom-up */ \
+    name##_node** path[AVL_TYPED_MAX_HEIGHT]; \
+    size_t depth = 0; \
+    name##_node** link = &t->root; \
+\
+    while(*link) { \
+        int c = cmp(key, (*link)->key); \
+        if(c == 0) { \
+            (*link)->val = val; \
+            return; \
+        } \
+        path[depth++] = link; \
+        link = c < 0 ? &(*link)->left : &(*link)->right; \
+    } \
+\
+    name##_node* n = (name##_node*)mp_alloc(t->pool); \
+    n->key = key; \
+    n->val = val; \
+    n->height = 1; \
+    n->left = n->right = NULL; \
+    *link = n; \
+    t->length++; \
+\
+    /* ancestors above a sub-tree that keeps its height stay the same */ \
+    while(depth--) { \
+        name##_node** l = path[depth]; \
+        int height = (*l)->height; \
+        *l = name##_balance_(*l); \
+        if((*l)->height == height) break; \
+    } \
+} \
+\
+static inline void name##_unset(name* t, ktype key) \
+{ \
+    name##_node** path[AVL_TYPED_MAX_HEIGHT]; \
+    size_t depth = 0; \
+    name##_node** link = &t->root; \
+\
+    int c; \
+    while(*link && (c = cmp(key, (*link)->key)) != 0) { \
+        path[depth++] = link; \
+        link = c < 0 ? &(*link)->left : &(*link)->right; \
+    } \
+    if(!*link) toss(KeyNotFound); \
+\
+    name##_node* n = *link; \
+    if(n->left && n->right) { \
+        /* take over the entry of the successor and remove that instead */ \
+        path[depth++] = link; \
+        link = &n->right; \
+        while((*link)->left) { \
+            path[depth++] = link; \
+            link = &(*link)->left; \
+        } \
+        n->key = (*link)->key; \
+        n->val = (*link)->val; \
+        n = *link; \
+    } \
+\
+    *link = n->left ? n->left : n->right; \
+    mp_free(t->pool, n); \
+    t->length--; \
+\
+    while(depth--) \
+        *path[depth] = name##_balance_(*path[depth]); \
+}
+
+#endif // AVLTYPED_H_INCLUDED
@@ -0,0 +1,319 @@
+/*
+ * Copyright(c) 2015, Shihira Fung <fengzhiping@hotmail.com>
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "b_file.h"
+#include "exception.h"
+
+#define BF_MAGIC "DSBTREE1"
+// the header shares page 0, and a page must hold at least one page header
+#define BF_MIN_PAGE (sizeof(bf_header) + sizeof(bf_page))
+
+#define headerof(bf) ((bf_header*)(bf)->base)
+#define pageof(bf, id) ((bf_page*)((bf)->base + (id) * headerof(bf)->page_size))
+#define childrenof(p) ((uint64_t*)((p) + 1))
+#define max_keys(h) ((h)->degree - 1)
+
+static uint8_t* bf_keys_(bf_header* h, bf_page* p)
+{
+    return p->leaf ? (uint8_t*)(p + 1) :
+        (uint8_t*)(childrenof(p) + h->degree + 1);
+}
+
+#define key_at(h, p, i) (bf_keys_(h, p) + (i) * (h)->key_size)
+#define val_at(h, p, i) \
+    (bf_keys_(h, p) + (h)->degree * (h)->key_size + (i) * (h)->val_size)
+
+static void bf_map_(b_file* bf, size_t size)
+{
+    if(bf->base) munmap(bf->base, bf->mapped);
+
+    bf->base = (uint8_t*)mmap(NULL, size, PROT_READ | PROT_WRITE,
+            MAP_SHARED, bf->fd, 0);
+    if(bf->base == MAP_FAILED) {
+        bf->base = NULL;
+        toss(MapError);
+    }
+    bf->mapped = size;
+}
+
+// the mapping may move, refetch page pointers after calling this
+static uint64_t bf_new_page_(b_file* bf, int leaf)
+{
+    bf_header* h = headerof(bf);
+    size_t page_size = h->page_size;
+
+    if((h->npages + 1) * page_size > bf->mapped) {
+        size_t size = bf->mapped * 2;
+        if(ftruncate(bf->fd, size)) toss(IOError);
+        bf_map_(bf, size);
+        h = headerof(bf);
+    }
+
+    uint64_t id = h->npages++;
+    bf_page* p = pageof(bf, id);
+    p->leaf = leaf;
+    p->nkeys = 0;
+    p->prev = p->next = 0;
+
+    return id;
+}
+
+// unmap and close whatever bf has got so far, and free it
+static void bf_release_(b_file* bf)
+{
+    if(bf->base) munmap(bf->base, bf->mapped);
+    if(bf->fd >= 0) close(bf->fd);
+    free(bf);
+}
+
+static void bf_init_(b_file* bf, char const* path, size_t szkey, size_t szval,
+        size_t page_size)
+{
+    bf->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if(bf->fd < 0) toss(IOError);
+
+    struct stat st;
+    if(fstat(bf->fd, &st)) toss(IOError);
+
+    if(st.st_size) {
+        size_t size = st.st_size;
+        if(size < sizeof(bf_header)) toss(IncompatibleFile);
+        bf_map_(bf, size);
+        bf_header* h = headerof(bf);
+        // a truncated or corrupted header must not send pageof out of the map
+        if(memcmp(h->magic, BF_MAGIC, 8) || h->key_size != szkey ||
+                h->val_size != szval || h->page_size < BF_MIN_PAGE ||
+                h->npages > size / h->page_size)
+            toss(IncompatibleFile);
+        return;
+    }
+
+    if(page_size < BF_MIN_PAGE) toss(InvalidPageSize);
+
+    // a node has room for one more key than degree - 1 before splitting
+    size_t leaf_cap = (page_size - sizeof(bf_page)) / (szkey + szval);
+    size_t node_cap = (page_size - sizeof(bf_page) - sizeof(uint64_t)) /
+        (szkey + sizeof(uint64_t));
+    size_t degree = leaf_cap < node_cap ? leaf_cap : node_cap;
+    if(degree < 3) toss(InvalidPageSize);
+
+    if(ftruncate(bf->fd, page_size * 2)) toss(IOError);
+    bf_map_(bf, page_size * 2);
+
+    bf_header* h = headerof(bf);
+    memcpy(h->magic, BF_MAGIC, 8);
+    h->page_size = page_size;
+    h->degree = degree;
+    h->key_size = szkey;
+    h->val_size = szval;
+    h->npages = 1;
+    h->length = 0;
+    h->root = h->first = bf_new_page_(bf, 1);
+}
+
+b_file* bf_open(char const* path, size_t szkey, size_t szval, b_cmp cmp,
+        size_t page_size, bf_sync_policy policy)
+{
+    b_file* bf = (b_file*)malloc(sizeof(b_file));
+    if(!bf) toss(MemoryError);
+
+    bf->fd = -1;
+    bf->base = NULL;
+    bf->cmp = cmp;
+    bf->policy = policy;
+
+    // release the file on any failure and pass the error on
+    examine { bf_init_(bf, path, szkey, szval, page_size); }
+    grab_else {
+        bf_release_(bf);
+        next_handler_or_abort_();
+    }
+
+    return bf;
+}
+
+void bf_sync(b_file* bf)
+{
+    if(msync(bf->base, bf->mapped, MS_SYNC)) toss(IOError);
+}
+
+static void bf_written_(b_file* bf)
+{
+    if(bf->policy == BF_SYNC_EACH) bf_sync(bf);
+    else if(bf->policy == BF_SYNC_ASYNC)
+        msync(bf->base, bf->mapped, MS_ASYNC);
+}
+
+void bf_close(b_file* bf)
+{
+    bf_sync(bf);
+    bf_release_(bf);
+}
+
+size_t bf_length(b_file* bf)
+{ return headerof(bf)->length; }
+
+static size_t bf_lower_bound_(b_file* bf, bf_page* p,
+        void const* key, int* found)
+{
+    bf_header* h = headerof(bf);
+    size_t lo = 0, hi = p->nkeys;
+
+    *found = 0;
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int cmp = bf->cmp(key_at(h, p, mid), key);
+        if(cmp < 0) lo = mid + 1;
+        else {
+            if(cmp == 0) *found = 1;
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+static bf_page* bf_find_leaf_(b_file* bf, void const* key)
+{
+    bf_page* p = pageof(bf, headerof(bf)->root);
+    while(!p->leaf) {
+        int found;
+        size_t i = bf_lower_bound_(bf, p, key, &found);
+        p = pageof(bf, childrenof(p)[found ? i + 1 : i]);
+    }
+    return p;
+}
+
+void* bf_get(b_file* bf, void const* key)
+{
+    bf_page* p = bf_find_leaf_(bf, key);
+
+    int found;
+    size_t i = bf_lower_bound_(bf, p, key, &found);
+    return found ? val_at(headerof(bf), p, i) : NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Insertion
+
+static uint64_t bf_split_(b_file* bf, uint64_t id, uint8_t* sep)
+{
+    uint64_t rid = bf_new_page_(bf, pageof(bf, id)->leaf);
+    bf_header* h = headerof(bf);
+    bf_page *n = pageof(bf, id), *r = pageof(bf, rid);
+
+    if(n->leaf) {
+        size_t keep = (n->nkeys + 1) / 2;
+        r->nkeys = n->nkeys - keep;
+        memcpy(key_at(h, r, 0), key_at(h, n, keep), r->nkeys * h->key_size);
+        memcpy(val_at(h, r, 0), val_at(h, n, keep), r->nkeys * h->val_size);
+        n->nkeys = keep;
+        memcpy(sep, key_at(h, r, 0), h->key_size);
+
+        r->prev = id;
+        r->next = n->next;
+        if(n->next) pageof(bf, n->next)->prev = rid;
+        n->next = rid;
+    } else {
+        size_t keep = n->nkeys / 2;
+        r->nkeys = n->nkeys - keep - 1;
+        memcpy(sep, key_at(h, n, keep), h->key_size);
+        memcpy(key_at(h, r, 0), key_at(h, n, keep + 1), r->nkeys * h->key_size);
+        memcpy(childrenof(r), childrenof(n) + keep + 1,
+                (r->nkeys + 1) * sizeof(uint64_t));
+        n->nkeys = keep;
+    }
+
+    return rid;
+}
+
+static uint64_t bf_insert_(b_file* bf, uint64_t id,
+        void const* key, void const* val, uint8_t* sep)
+{
+    bf_header* h = headerof(bf);
+    bf_page* n = pageof(bf, id);
+
+    int found;
+    size_t i = bf_lower_bound_(bf, n, key, &found);
+
+    if(n->leaf) {
+        if(found) {
+            memcpy(val_at(h, n, i), val, h->val_size);
+            return 0;
+        }
+
+        memmove(key_at(h, n, i + 1), key_at(h, n, i),
+                (n->nkeys - i) * h->key_size);
+        memmove(val_at(h, n, i + 1), val_at(h, n, i),
+                (n->nkeys - i) * h->val_size);
+        memcpy(key_at(h, n, i), key, h->key_size);
+        memcpy(val_at(h, n, i), val, h->val_size);
+        n->nkeys++;
+        h->length++;
+    } else {
+        if(found) i++;
+        uint8_t child_sep[h->key_size];
+        uint64_t rid = bf_insert_(bf, childrenof(n)[i], key, val, child_sep);
+        if(!rid) return 0;
+
+        // children may have grown the file
+        h = headerof(bf);
+        n = pageof(bf, id);
+        memmove(key_at(h, n, i + 1), key_at(h, n, i),
+                (n->nkeys - i) * h->key_size);
+        memmove(childrenof(n) + i + 2, childrenof(n) + i + 1,
+                (n->nkeys - i) * sizeof(uint64_t));
+        memcpy(key_at(h, n, i), child_sep, h->key_size);
+        childrenof(n)[i + 1] = rid;
+        n->nkeys++;
+    }
+
+    return n->nkeys > max_keys(h) ? bf_split_(bf, id, sep) : 0;
+}
+
+void bf_set(b_file* bf, void const* key, void const* val)
+{
+    uint8_t sep[headerof(bf)->key_size];
+    uint64_t rid = bf_insert_(bf, headerof(bf)->root, key, val, sep);
+
+    if(rid) {
+        uint64_t root = bf_new_page_(bf, 0);
+        bf_header* h = headerof(bf);
+        bf_page* p = pageof(bf, root);
+
+        memcpy(key_at(h, p, 0), sep, h->key_size);
+        childrenof(p)[0] = h->root;
+        childrenof(p)[1] = rid;
+        p->nkeys = 1;
+        h->root = root;
+    }
+
+    bf_written_(bf);
+}
+
+void bf_unset(b_file* bf, void const* key)
+{
+    bf_header* h = headerof(bf);
+    bf_page* p = bf_find_leaf_(bf, key);
+
+    int found;
+    size_t i = bf_lower_bound_(bf, p, key, &found);
+    if(!found) toss(KeyNotFound);
+
+    memmove(key_at(h, p, i), key_at(h, p, i + 1),
+            (p->nkeys - i - 1) * h->key_size);
+    memmove(val_at(h, p, i), val_at(h, p, i + 1),
+            (p->nkeys - i - 1) * h->val_size);
+    p->nkeys--;
+    h->length--;
+
+    bf_written_(bf);
+}
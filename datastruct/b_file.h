@@ -0,0 +1,74 @@
+/*
+ * Copyright(c) 2015, Shihira Fung <fengzhiping@hotmail.com>
+ */
+
+#ifndef B_FILE_H_INCLUDED
+#define B_FILE_H_INCLUDED
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "b_tree.h"
+
+/*
+ * b_file is a B+ tree persisted in a memory-mapped file. The file is an array
+ * of fixed-size pages: page 0 is the header and every other page is a node,
+ * laid out like b_node but referring to children and sibling leaves by page
+ * number instead of by address. Opening a file only maps it, and pages are
+ * brought in lazily by the OS as they are touched, so the cost of opening an
+ * index doesn't depend on its size.
+ *
+ * Pointers returned by bf_get point into the mapping and stay valid until the
+ * next bf_set, which may grow and remap the file.
+ *
+ * Removal only takes the entry out of its leaf. Nodes are not merged and
+ * pages are not reclaimed, which is harmless for lookups.
+ */
+
+typedef enum bf_sync_policy_e_ {
+    BF_SYNC_MANUAL, // write back on bf_sync, bf_close, or whenever OS does
+    BF_SYNC_ASYNC,  // schedule write-back after every update
+    BF_SYNC_EACH,   // wait for write-back after every update
+} bf_sync_policy;
+
+typedef struct bf_header_t_ {
+    char magic[8];
+    uint32_t page_size;
+    uint32_t degree;
+    uint64_t key_size;
+    uint64_t val_size;
+    uint64_t root;
+    uint64_t first; // leftmost leaf
+    uint64_t npages;
+    uint64_t length;
+} bf_header;
+
+typedef struct bf_page_t_ {
+    uint32_t leaf;
+    uint32_t nkeys;
+    uint64_t prev; // sibling leaves, 0 for none
+    uint64_t next;
+} bf_page;
+
+typedef struct b_file_t_ {
+    int fd;
+    uint8_t* base;
+    size_t mapped;
+    b_cmp cmp;
+    bf_sync_policy policy;
+} b_file;
+
+// page_size is used only when creating the file
+b_file* bf_open(char const* path, size_t szkey, size_t szval, b_cmp cmp,
+        size_t page_size, bf_sync_policy policy);
+void bf_close(b_file* bf);
+void bf_sync(b_file* bf);
+size_t bf_length(b_file* bf);
+
+void* bf_get(b_file* bf, void const* key);
+void bf_set(b_file* bf, void const* key, void const* val);
+void bf_unset(b_file* bf, void const* key);
+
+#define BF_DEFAULT_PAGE 4096
+
+#endif // B_FILE_H_INCLUDED
@@ -3,19 +3,39 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "b_tree.h"
+#include "dsstat.h"
 #include "exception.h"
 
-#define derent(i) ((b_entry*)i->data) // DEReference to ENTry
-#define b_is_end(e) (!(e->key))
+// nodes hold one more key than allowed, so that they split after insertion
+#define max_keys(b_t) ((b_t)->degree - 1)
+#define min_keys(b_t, n) ((n)->leaf ? (b_t)->degree / 2 : ((b_t)->degree - 1) / 2)
+#define align8(n) (((n) + 7) / 8 * 8)
 
-b_node* b_new_node_(lnklist* new_entries)
+#define key_at(b_t, n, i) b_key(b_t, n, i)
+#define val_at(b_t, n, i) b_val(b_t, n, i)
+#define key_cmp(b_t, a, b) ds_stat_cmp(DS_STAT_B_TREE, (b_t)->cmp, a, b)
+
+b_node* b_new_node_(b_tree* b_t, int leaf)
 {
-    b_node* n = (b_node*)malloc(sizeof(b_node));
-    n->entries = new_entries;
-    n->parentn = NULL;
-    n->right = NULL;
+    size_t szkeys = align8(b_t->degree * b_t->key_size);
+    size_t szchildren = leaf ? 0 : (b_t->degree + 1) * sizeof(b_node*);
+    size_t szvals = leaf ? b_t->degree * b_t->val_size : 0;
+
+    b_node* n = (b_node*)malloc(sizeof(b_node) + szchildren + szkeys + szvals);
+    if(!n) toss(MemoryError);
+    ds_stat_alloc(DS_STAT_B_TREE, sizeof(b_node) + szchildren + szkeys + szvals);
+
+    n->nkeys = 0;
+    n->leaf = leaf;
+    n->key_size = b_t->key_size;
+    n->val_size = b_t->val_size;
+    n->prev = n->next = NULL;
+    n->children = leaf ? NULL : (b_node**)(n + 1);
+    n->keys = (uint8_t*)(n + 1) + szchildren;
+    n->vals = leaf ? n->keys + szkeys : NULL;
 
     return n;
 }
@@ -29,320 +49,672 @@ b_tree* b_create_(size_t degree, size_t szkey, size_t szval, b_cmp cmp)
     if(!b_t) toss(MemoryError);
     b_t->key_size = szkey;
     b_t->val_size = szval;
-    b_t->root = b_new_node_(ll_create(b_entry));
     b_t->cmp = cmp;
     b_t->degree = degree;
+    b_t->length = 0;
+    b_t->version = 0;
+    pthread_rwlock_init(&b_t->lock, NULL);
+    b_t->root = b_t->first = b_new_node_(b_t, 1);
 
     return b_t;
 }
 
-void b_traverse(b_node* n, b_traverse_order to,
-    void (*cb) (b_entry*, void*), void* usr)
+/*
+ * For keys compared by `cmpi` or `cmpi64` the search counts smaller keys with
+ * a branchless loop which compilers vectorize. Otherwise it's a binary search.
+ * Either way it returns the index of the first key not less than `key`.
+ */
+static size_t b_lower_bound_(b_tree* b_t, b_node* n,
+        void const* key, int* found)
 {
-    if(!n) return;
-    if(to == lpr) {
-        for(ll_iter i = n->entries->head;
-                !ll_is_end(i); i = i->next) {
-            b_traverse(derent(i)->left, to, cb, usr);
-            cb(derent(i), usr);
+    size_t lo = 0, hi = n->nkeys;
+
+    if(b_t->cmp == cmpi && b_t->key_size == sizeof(int32_t)) {
+        int32_t k = *(int32_t const*)key, * keys = (int32_t*)n->keys;
+        for(size_t i = 0; i < hi; i++) lo += keys[i] < k;
+        ds_stat_add(DS_STAT_B_TREE, DS_STAT_COMPARES, hi);
+        *found = lo < hi && keys[lo] == k;
+        return lo;
+    } else if(b_t->cmp == cmpi64 && b_t->key_size == sizeof(int64_t)) {
+        int64_t k = *(int64_t const*)key, * keys = (int64_t*)n->keys;
+        for(size_t i = 0; i < hi; i++) lo += keys[i] < k;
+        ds_stat_add(DS_STAT_B_TREE, DS_STAT_COMPARES, hi);
+        *found = lo < hi && keys[lo] == k;
+        return lo;
+    }
+
+    *found = 0;
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int cmp = key_cmp(b_t, key_at(b_t, n, mid), key);
+        if(cmp < 0) lo = mid + 1;
+        else {
+            if(cmp == 0) *found = 1;
+            hi = mid;
         }
-        b_traverse(n->right, to, cb, usr);
-    } else if(to == plr) {
-        for(ll_iter i = n->entries->head;
-                !ll_is_end(i); i = i->next)
-            cb(derent(i), usr);
-        for(ll_iter i = n->entries->head;
-                !ll_is_end(i); i = i->next)
-            b_traverse(derent(i)->left, to, cb, usr);
-        b_traverse(n->right, to, cb, usr);
-    } else if(to == lrp) {
-        for(ll_iter i = n->entries->head;
-                !ll_is_end(i); i = i->next)
-            b_traverse(derent(i)->left, to, cb, usr);
-        b_traverse(n->right, to, cb, usr);
-        for(ll_iter i = n->entries->head;
-                !ll_is_end(i); i = i->next)
-            cb(derent(i), usr);
     }
+
+    return lo;
 }
 
-void b_rm_node_recur_(b_node* n)
+// index of the child whose range covers `key`
+static size_t b_child_index_(b_tree* b_t, b_node* n, void const* key)
 {
+    int found;
+    size_t i = b_lower_bound_(b_t, n, key, &found);
+    return found ? i + 1 : i;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Traversal
+
+// calls either cb on every entry or batch on blocks of them
+typedef struct b_walker_t_ {
+    void (*cb) (b_entry*, void*);
+    void (*batch) (b_entry*, size_t, void*);
+    void* usr;
+    b_entry block[B_BATCH];
+    size_t nblock;
+} b_walker_;
+
+// emit all keys of n, along with values if n is a leaf
+static void b_emit_(b_walker_* w, b_node* n)
+{
+    for(size_t i = 0; i < n->nkeys; i++) {
+        b_entry e = { n->keys + i * n->key_size,
+            n->leaf ? n->vals + i * n->val_size : NULL };
+        if(!w->batch) {
+            w->cb(&e, w->usr);
+            continue;
+        }
+        w->block[w->nblock++] = e;
+        if(w->nblock == B_BATCH) {
+            w->batch(w->block, w->nblock, w->usr);
+            w->nblock = 0;
+        }
+    }
+}
+
+typedef struct b_frame_t_ {
+    b_node* node;
+    size_t next; // index of the next child to visit
+} b_frame_;
+
+static void b_walk_(b_node* n, b_traverse_order to, b_walker_* w)
+{
+    if(to != lpr && to != plr && to != lrp) toss(InvalidOrder);
     if(!n) return;
-    for(ll_iter i = n->entries->head; !ll_is_end(i); i = i->next) {
-        b_entry* e = derent(i);
-        b_rm_node_recur_(e->left);
-        if(e->key) free(e->key); e->key = NULL;
-        if(e->val) free(e->val); e->val = NULL;
+
+    if(to == lpr) {
+        // the leaves of n are a run of the leaf list
+        b_node* first = n, * last = n;
+        while(!first->leaf) first = first->children[0];
+        while(!last->leaf) last = last->children[last->nkeys];
+
+        for(b_node* leaf = first; ; leaf = leaf->next) {
+            if(leaf != last) ds_prefetch(leaf->next);
+            b_emit_(w, leaf);
+            if(leaf == last) break;
+        }
+        return;
+    }
+
+    // internal nodes have 2 children at least, so 64 levels are plenty
+    b_frame_ stack[64];
+    size_t top = 0;
+
+    if(to == plr || n->leaf) b_emit_(w, n);
+    if(n->leaf) return;
+    stack[top].node = n;
+    stack[top++].next = 0;
+
+    while(top) {
+        b_frame_* f = stack + top - 1;
+        b_node* p = f->node;
+        if(f->next > p->nkeys) {
+            if(to == lrp) b_emit_(w, p);
+            top--;
+            continue;
+        }
+
+        b_node* c = p->children[f->next++];
+        if(f->next <= p->nkeys) ds_prefetch(p->children[f->next]);
+
+        if(to == plr || c->leaf) b_emit_(w, c);
+        if(!c->leaf) {
+            stack[top].node = c;
+            stack[top++].next = 0;
+        }
     }
-    b_rm_node_recur_(n->right);
+}
 
-    ll_destroy(n->entries);
+void b_traverse(b_node* n, b_traverse_order to,
+    void (*cb) (b_entry*, void*), void* usr)
+{
+    b_walker_ w;
+    w.cb = cb;
+    w.batch = NULL;
+    w.usr = usr;
+    w.nblock = 0;
+    b_walk_(n, to, &w);
+}
+
+void b_traverse_batch(b_node* n, b_traverse_order to,
+    void (*cb) (b_entry*, size_t, void*), void* usr)
+{
+    b_walker_ w;
+    w.cb = NULL;
+    w.batch = cb;
+    w.usr = usr;
+    w.nblock = 0;
+    b_walk_(n, to, &w);
+    if(w.nblock) cb(w.block, w.nblock, usr);
+}
+
+void b_rm_node_recur_(b_node* n)
+{
+    if(!n->leaf)
+        for(size_t i = 0; i <= n->nkeys; i++)
+            b_rm_node_recur_(n->children[i]);
     free(n);
+    ds_stat_free(DS_STAT_B_TREE);
 }
 
 void b_destroy(b_tree* b_t)
 {
     b_rm_node_recur_(b_t->root);
+    pthread_rwlock_destroy(&b_t->lock);
     free(b_t);
 }
 
+void* b_get(b_tree* b_t, void* key)
+{
+    b_node* n = b_t->root;
+    while(!n->leaf)
+        n = n->children[b_child_index_(b_t, n, key)];
+
+    int found;
+    size_t i = b_lower_bound_(b_t, n, key, &found);
+    return found ? val_at(b_t, n, i) : NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Insertion
+
+// open a gap at i in keys (and vals or children right to keys)
+static void b_shift_right_(b_tree* b_t, b_node* n, size_t i)
+{
+    memmove(key_at(b_t, n, i + 1), key_at(b_t, n, i),
+            (n->nkeys - i) * b_t->key_size);
+    if(n->leaf)
+        memmove(val_at(b_t, n, i + 1), val_at(b_t, n, i),
+                (n->nkeys - i) * b_t->val_size);
+    else
+        memmove(n->children + i + 2, n->children + i + 1,
+                (n->nkeys - i) * sizeof(b_node*));
+}
+
+// close the gap at i in keys (and vals or children right to keys)
+static void b_shift_left_(b_tree* b_t, b_node* n, size_t i)
+{
+    memmove(key_at(b_t, n, i), key_at(b_t, n, i + 1),
+            (n->nkeys - i - 1) * b_t->key_size);
+    if(n->leaf)
+        memmove(val_at(b_t, n, i), val_at(b_t, n, i + 1),
+                (n->nkeys - i - 1) * b_t->val_size);
+    else
+        memmove(n->children + i + 1, n->children + i + 2,
+                (n->nkeys - i - 1) * sizeof(b_node*));
+}
+
 /*
- * `b_absorb_` find the proper insert point, and move contents in `l` to `n`,
- * after passing `l` to a deeper level of children. If insertion corrupts the
- * properties of B-tree node, detach surplus nodes and move them to `l`.
+ * Split an overflowing node and return its new right sibling, whose smallest
+ * key (for leaves) or the key moving up (for internal nodes) goes to `sep`.
  */
-b_entry* b_absorb_(b_tree* b_t, b_node* n, void* key, void* val, lnklist* l)
+static b_node* b_split_(b_tree* b_t, b_node* n, uint8_t* sep)
 {
-    static b_entry empty_entry = { NULL, NULL, NULL, };
+    b_node* r = b_new_node_(b_t, n->leaf);
+    ds_stat_inc(DS_STAT_B_TREE, DS_STAT_SPLITS);
+
+    if(n->leaf) {
+        size_t keep = (n->nkeys + 1) / 2;
+        r->nkeys = n->nkeys - keep;
+        memcpy(r->keys, key_at(b_t, n, keep), r->nkeys * b_t->key_size);
+        memcpy(r->vals, val_at(b_t, n, keep), r->nkeys * b_t->val_size);
+        n->nkeys = keep;
+        memcpy(sep, r->keys, b_t->key_size);
+
+        r->prev = n;
+        r->next = n->next;
+        if(n->next) n->next->prev = r;
+        n->next = r;
+    } else {
+        size_t keep = n->nkeys / 2;
+        r->nkeys = n->nkeys - keep - 1;
+        memcpy(sep, key_at(b_t, n, keep), b_t->key_size);
+        memcpy(r->keys, key_at(b_t, n, keep + 1), r->nkeys * b_t->key_size);
+        memcpy(r->children, n->children + keep + 1,
+                (r->nkeys + 1) * sizeof(b_node*));
+        n->nkeys = keep;
+    }
 
-    if(n == NULL) { // boundary condition
-        ll_prepend(l, &empty_entry);
-        b_entry* new_entry = derent(l->head);
+    return r;
+}
 
-        new_entry->key = (uint8_t*)malloc(b_t->key_size);
-        if(!new_entry->key) toss(MemoryError);
-        memcpy(new_entry->key, key, b_t->key_size);
+static b_node* b_insert_(b_tree* b_t, b_node* n,
+        void const* key, void const* val, uint8_t* sep)
+{
+    int found;
+    size_t i = b_lower_bound_(b_t, n, key, &found);
 
-        new_entry->val = (uint8_t*)malloc(b_t->val_size);
-        if(!new_entry->val) toss(MemoryError);
-        memcpy(new_entry->val, val, b_t->val_size);
+    if(n->leaf) {
+        if(found) {
+            memcpy(val_at(b_t, n, i), val, b_t->val_size);
+            return NULL;
+        }
 
-        return new_entry;
+        b_shift_right_(b_t, n, i);
+        memcpy(key_at(b_t, n, i), key, b_t->key_size);
+        memcpy(val_at(b_t, n, i), val, b_t->val_size);
+        n->nkeys++;
+        b_t->length++;
+        b_t->version++;
+    } else {
+        if(found) i++;
+        uint8_t child_sep[b_t->key_size];
+        b_node* r = b_insert_(b_t, n->children[i], key, val, child_sep);
+        if(!r) return NULL;
+
+        b_shift_right_(b_t, n, i);
+        memcpy(key_at(b_t, n, i), child_sep, b_t->key_size);
+        n->children[i + 1] = r;
+        n->nkeys++;
     }
 
-    ll_iter i = n->entries->head;
-    for(; !ll_is_end(i); i = i->next) {
-        int cmp = b_t->cmp(derent(i)->key, key);
-        if(cmp == 0) {
-            memcpy(derent(i)->val, val, b_t->val_size);
-            return derent(i);
-        }
-        if(cmp > 0) break;
+    return n->nkeys > max_keys(b_t) ? b_split_(b_t, n, sep) : NULL;
+}
+
+void b_set(b_tree* b_t, void* key, void* val)
+{
+    uint8_t sep[b_t->key_size];
+    b_node* r = b_insert_(b_t, b_t->root, key, val, sep);
+
+    if(r) {
+        b_node* new_root = b_new_node_(b_t, 0);
+        memcpy(new_root->keys, sep, b_t->key_size);
+        new_root->children[0] = b_t->root;
+        new_root->children[1] = r;
+        new_root->nkeys = 1;
+        b_t->root = new_root;
     }
-    b_node* past_entry_left = ll_is_end(i) ? n->right : derent(i)->left;
-    b_entry* new_entry = b_absorb_(b_t, past_entry_left, key, val, l);
-
-    if(l->length > 0) {
-        b_entry* new_inserted = derent(l->head);
-        b_node** right/*of the surplus pivot*/ = ll_is_end(i) ?
-                &(n->right) : &(derent(i)->left);
-        ll_move_bef(n->entries, l, i, l->head, 1);
-
-        // NOTE: ... and then we got the address of new_node. Thus, the past
-        // entry's left is new_node, and new inserted entry's left is the
-        // original node.
-        b_node* t = *right;
-        *right = new_inserted->left;
-        new_inserted->left = t;
-
-        if(*right) (*right)->parentn = n;
-        if(new_inserted->left) new_inserted->left->parentn = n;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Removal
+
+// move the last entry of children[i-1] to the front of children[i]
+static void b_borrow_left_(b_tree* b_t, b_node* p, size_t i)
+{
+    b_node *l = p->children[i - 1], *n = p->children[i];
+
+    b_shift_right_(b_t, n, 0);
+    if(n->leaf) {
+        memcpy(key_at(b_t, n, 0), key_at(b_t, l, l->nkeys - 1), b_t->key_size);
+        memcpy(val_at(b_t, n, 0), val_at(b_t, l, l->nkeys - 1), b_t->val_size);
+        memcpy(key_at(b_t, p, i - 1), key_at(b_t, n, 0), b_t->key_size);
+    } else {
+        // b_shift_right_ keeps children[0], which moves by hand
+        n->children[1] = n->children[0];
+        n->children[0] = l->children[l->nkeys];
+        memcpy(key_at(b_t, n, 0), key_at(b_t, p, i - 1), b_t->key_size);
+        memcpy(key_at(b_t, p, i - 1), key_at(b_t, l, l->nkeys - 1),
+                b_t->key_size);
     }
 
-    if(n->entries->length == b_t->degree) {
-        // move pivot to temporary entry list
-        ll_iter pivot = ll_iter_at(n->entries, b_t->degree / 2);
-        ll_iter parted = pivot->next;
-        ll_move_bef(l, n->entries, l->head, pivot, 1);
-
-        // split current node on removing pivot
-        b_node* parted_node = b_new_node_(ll_create(b_entry));
-        ll_move_bef(parted_node->entries, n->entries,
-                parted_node->entries->head, parted, n->entries->length);
-        parted_node->right = n->right;
-        n->right = derent(pivot)->left;
-        // NOTE: the new node is the right node of pivot
-        // but we store it in its left first, and then ...
-        derent(pivot)->left = parted_node;
+    n->nkeys++;
+    l->nkeys--;
+}
+
+// move the first entry of children[i+1] to the back of children[i]
+static void b_borrow_right_(b_tree* b_t, b_node* p, size_t i)
+{
+    b_node *n = p->children[i], *r = p->children[i + 1];
+
+    if(n->leaf) {
+        memcpy(key_at(b_t, n, n->nkeys), r->keys, b_t->key_size);
+        memcpy(val_at(b_t, n, n->nkeys), r->vals, b_t->val_size);
+        b_shift_left_(b_t, r, 0);
+        memcpy(key_at(b_t, p, i), r->keys, b_t->key_size);
+    } else {
+        memcpy(key_at(b_t, n, n->nkeys), key_at(b_t, p, i), b_t->key_size);
+        n->children[n->nkeys + 1] = r->children[0];
+        memcpy(key_at(b_t, p, i), r->keys, b_t->key_size);
+        r->children[0] = r->children[1];
+        b_shift_left_(b_t, r, 0);
     }
 
-    return new_entry;
+    n->nkeys++;
+    r->nkeys--;
 }
 
-void b_set(b_tree* b_t, void* key, void* val)
+// merge children[i+1] into children[i], dropping the key between them
+static void b_merge_(b_tree* b_t, b_node* p, size_t i)
 {
-    lnklist* surplus = ll_create(b_entry);
-    b_absorb_(b_t, b_t->root, key, val, surplus);
+    b_node *l = p->children[i], *r = p->children[i + 1];
+
+    if(l->leaf) {
+        memcpy(key_at(b_t, l, l->nkeys), r->keys, r->nkeys * b_t->key_size);
+        memcpy(val_at(b_t, l, l->nkeys), r->vals, r->nkeys * b_t->val_size);
+        l->nkeys += r->nkeys;
+
+        l->next = r->next;
+        if(r->next) r->next->prev = l;
+    } else {
+        memcpy(key_at(b_t, l, l->nkeys), key_at(b_t, p, i), b_t->key_size);
+        memcpy(key_at(b_t, l, l->nkeys + 1), r->keys,
+                r->nkeys * b_t->key_size);
+        memcpy(l->children + l->nkeys + 1, r->children,
+                (r->nkeys + 1) * sizeof(b_node*));
+        l->nkeys += r->nkeys + 1;
+    }
+
+    b_shift_left_(b_t, p, i);
+    p->nkeys--;
+    free(r);
+    ds_stat_inc(DS_STAT_B_TREE, DS_STAT_MERGES);
+    ds_stat_free(DS_STAT_B_TREE);
+}
 
-    if(surplus->length > 0) {
-        b_node* new_root = b_new_node_(ll_create(b_entry));
-        b_entry* surplus_entry = derent(surplus->head);
-        ll_move_bef(new_root->entries, surplus,
-                new_root->entries->head, surplus->head, 1);
+static void b_erase_(b_tree* b_t, b_node* n, void const* key)
+{
+    int found;
+    size_t i = b_lower_bound_(b_t, n, key, &found);
+
+    if(n->leaf) {
+        if(!found) toss(KeyNotFound);
+        b_shift_left_(b_t, n, i);
+        n->nkeys--;
+        b_t->length--;
+        b_t->version++;
+        return;
+    }
 
-        new_root->right = surplus_entry->left;
-        new_root->right->parentn = new_root;
-        surplus_entry->left = b_t->root;
-        surplus_entry->left->parentn = new_root;
+    if(found) i++;
+    b_node* c = n->children[i];
+    b_erase_(b_t, c, key);
+    if(c->nkeys >= min_keys(b_t, c)) return;
+
+    // rebalance the underflowing child with its siblings
+    if(i > 0 && n->children[i - 1]->nkeys > min_keys(b_t, c))
+        b_borrow_left_(b_t, n, i);
+    else if(i < n->nkeys && n->children[i + 1]->nkeys > min_keys(b_t, c))
+        b_borrow_right_(b_t, n, i);
+    else if(i > 0)
+        b_merge_(b_t, n, i - 1);
+    else
+        b_merge_(b_t, n, i);
+}
+
+void b_unset(b_tree* b_t, void* key)
+{
+    b_erase_(b_t, b_t->root, key);
 
+    if(!b_t->root->leaf && b_t->root->nkeys == 0) {
+        b_node* new_root = b_t->root->children[0];
+        free(b_t->root);
+        ds_stat_free(DS_STAT_B_TREE);
         b_t->root = new_root;
     }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Range Scan
+
+/*
+ * Find the first entry not less than (or greater than, if `strict`) `key`,
+ * or the first entry if key is null. Returns the leaf, or null if there is no
+ * such entry.
+ */
+static b_node* b_seek_(b_tree* b_t, void const* key, int strict, size_t* idx)
+{
+    b_node* n = b_t->first;
+    *idx = 0;
+
+    if(key) {
+        for(n = b_t->root; !n->leaf; )
+            n = n->children[b_child_index_(b_t, n, key)];
+
+        int found;
+        *idx = b_lower_bound_(b_t, n, key, &found);
+        if(found && strict) ++*idx;
+    }
 
-    ll_destroy(surplus);
+    // the position may be past the last key of a leaf
+    while(n && *idx >= n->nkeys) {
+        n = n->next;
+        *idx = 0;
+    }
+
+    return n;
 }
 
-void* b_get(b_tree* b_t, void* key)
+int b_lower_bound(b_tree* b_t, void const* key, b_entry* e)
 {
-    b_node* cur_node = b_t->root;
+    size_t i;
+    b_node* n = b_seek_(b_t, key, 0, &i);
+    if(!n) return 0;
 
-    while(cur_node) {
-        ll_iter i = cur_node->entries->head;
-        for(; !ll_is_end(i); i = i->next) {
-            int cmp = b_t->cmp(derent(i)->key, key);
-            if(cmp == 0) return derent(i)->val;
-            if(cmp > 0) {
-                cur_node = derent(i)->left;
-            }
+    e->key = key_at(b_t, n, i);
+    e->val = val_at(b_t, n, i);
+    return 1;
+}
+
+size_t b_range(b_tree* b_t, void const* begin, void const* end,
+    void (*cb) (b_entry*, void*), void* usr)
+{
+    size_t i, count = 0;
+    b_entry e;
+
+    for(b_node* n = b_seek_(b_t, begin, 0, &i); n; n = n->next, i = 0)
+        for(; i < n->nkeys; i++) {
+            e.key = key_at(b_t, n, i);
+            if(end && key_cmp(b_t, e.key, end) >= 0) return count;
+            e.val = val_at(b_t, n, i);
+            cb(&e, usr);
+            count++;
         }
 
-        if(ll_is_end(i))
-            cur_node = cur_node->right;
+    return count;
+}
+
+b_cursor* b_cursor_open(b_tree* b_t, void const* begin, void const* end)
+{
+    b_cursor* c = (b_cursor*)malloc(sizeof(b_cursor) + 2 * b_t->key_size);
+    if(!c) toss(MemoryError);
+
+    c->tree = b_t;
+    c->last = (uint8_t*)(c + 1);
+    c->end = c->last + b_t->key_size;
+    c->has_last = !!begin;
+    c->past_last = 0;
+    c->bounded = !!end;
+    if(begin) memcpy(c->last, begin, b_t->key_size);
+    if(end) memcpy(c->end, end, b_t->key_size);
+
+    c->leaf = b_seek_(b_t, begin, 0, &c->index);
+    c->version = b_t->version;
+
+    return c;
+}
+
+int b_cursor_next(b_cursor* c, b_entry* e)
+{
+    b_tree* b_t = c->tree;
+
+    if(c->version != b_t->version) {
+        // leaves might have been split, merged or freed since the last step
+        c->leaf = b_seek_(b_t, c->has_last ? c->last : NULL,
+                c->past_last, &c->index);
+        c->version = b_t->version;
     }
 
-    return NULL;
+    while(c->leaf && c->index >= c->leaf->nkeys) {
+        c->leaf = c->leaf->next;
+        c->index = 0;
+    }
+    if(!c->leaf) return 0;
+
+    uint8_t* key = key_at(b_t, c->leaf, c->index);
+    if(c->bounded && key_cmp(b_t, key, c->end) >= 0) {
+        c->leaf = NULL;
+        return 0;
+    }
+
+    e->key = key;
+    e->val = val_at(b_t, c->leaf, c->index);
+    memcpy(c->last, key, b_t->key_size);
+    c->has_last = c->past_last = 1;
+    c->index++;
+
+    return 1;
 }
 
-#define mindeg(b_t) (((b_t->degree)-1)/2)
-#define left_node(n, i) (*(ll_is_end(i)?&((n)->right):&(derent(i)->left)))
+void b_cursor_close(b_cursor* c)
+{ free(c); }
+
+////////////////////////////////////////////////////////////////////////////////
+// Bulk Loading
 
 /*
- * `b_rotate` finds `key` in the tree or finds maximum key for substitution,
- * followed by finding maximum key or removal of subs. Then the tree will get
- * automatical rebalancing on children.
- *
- * let `key` be the key, subs be null to find your target in n and n's children
- * let subs be your target, `key` be null to find target's predecessor as
- *     replacement in n and n's children.
+ * Spread `len` items over as few groups of about `target` items as possible,
+ * with at most `cap` items per group. Groups differ in size by at most one.
  */
-void b_rotate_(b_tree* b_t, b_node* n,
-        void* key, ll_iter subs, lnklist* subses)
+static size_t b_group_count_(size_t len, size_t target, size_t cap)
 {
-    if((key && subs) || (!key && !subs)) toss(InvalidMode);
+    size_t groups = len / target;
+    if(groups < (len + cap - 1) / cap) groups = (len + cap - 1) / cap;
+    return groups ? groups : 1;
+}
 
-    ll_iter proc = NULL; // record the target node as proc->left
+#define group_begin(len, groups, g) ((len) * (g) / (groups))
 
-    //// NODE REMOVAL
-    // mode of searching for key
-    if(key) {
-        ll_iter i = n->entries->head;
-        for(; !ll_is_end(i); i = i->next) {
-            b_entry* e = derent(i);
-
-            int cmp = b_t->cmp(e->key, key);
-
-            if(cmp < 0) continue;
-            if(cmp == 0) {
-                if(e->left) {
-                    // scenery protection
-                    ll_iter prev_i = i->prev;
-                    b_rotate_(b_t, e->left, NULL, i, n->entries);
-                    if(prev_i) i = prev_i->next;
-                    else i = n->entries->head;
-                } else {
-                    if(e->key) free(e->key);
-                    if(e->val) free(e->val);
-                    return ll_remove(n->entries, i);
-                }
-            }
-            if(cmp > 0) {
-                if(e->left)
-                    b_rotate_(b_t, e->left, key, NULL, NULL); 
-                else toss(KeyNotFound);
-            }
+static size_t b_fill_target_(double fill, size_t cap, size_t min)
+{
+    size_t target = (size_t)(cap * fill + 0.999999);
+    if(target < min) target = min;
+    if(target > cap) target = cap;
+    return target ? target : 1;
+}
 
-            break;
-        }
-        if(ll_is_end(i)) {
-            if(n->right) b_rotate_(b_t, n->right, key, NULL, NULL);
-            else toss(KeyNotFound);
+void b_bulk_load(b_tree* b_t, varray* sorted, double fill)
+{
+    size_t szkey = b_t->key_size, szval = b_t->val_size;
+    size_t len = sorted->length;
+
+    if(b_t->length) toss(NotEmpty);
+    if((size_t)sorted->elem_size != szkey + szval) toss(InvalidElemSize);
+    if(fill <= 0 || fill > 1) toss(InvalidFillFactor);
+    for(size_t i = 1; i < len; i++)
+        if(key_cmp(b_t, va_at(sorted, i - 1), va_at(sorted, i)) >= 0)
+            toss(UnsortedInput);
+    if(!len) return;
+
+    // level of nodes being built, and the lowest key under each of them
+    size_t nleaves = b_group_count_(len,
+        b_fill_target_(fill, max_keys(b_t), b_t->degree / 2), max_keys(b_t));
+    b_node** level = (b_node**)malloc(nleaves * sizeof(b_node*));
+    uint8_t** lows = (uint8_t**)malloc(nleaves * sizeof(uint8_t*));
+    if(!level || !lows) toss(MemoryError);
+
+    free(b_t->root);
+    ds_stat_free(DS_STAT_B_TREE);
+    for(size_t g = 0; g < nleaves; g++) {
+        size_t begin = group_begin(len, nleaves, g),
+               end = group_begin(len, nleaves, g + 1);
+        b_node* n = level[g] = b_new_node_(b_t, 1);
+
+        n->nkeys = end - begin;
+        for(size_t i = 0; i < n->nkeys; i++) {
+            uint8_t* e = va_at(sorted, begin + i);
+            memcpy(key_at(b_t, n, i), e, szkey);
+            memcpy(val_at(b_t, n, i), e + szkey, szval);
         }
-        proc = i;
-    }
+        lows[g] = n->keys;
 
-    // mode of searching for predecessor
-    if(subs) {
-        if(n->right) {
-            b_rotate_(b_t, n->right, NULL, subs, subses);
-            proc = n->entries->tail;
-        } else { // ended up to leaves. now replace and remove
-            ll_iter pre = n->entries->tail->prev;
-            ll_move_bef(subses, n->entries, subs, pre, 1);
-            derent(pre)->left = derent(subs)->left;
-            if(derent(subs)->left) derent(subs)->left->parentn = n;
-
-            if(derent(subs)->key) free(derent(subs)->key);
-            if(derent(subs)->val) free(derent(subs)->val);
-            return ll_remove(subses, subs);
-        }
+        n->prev = g ? level[g - 1] : NULL;
+        if(g) level[g - 1]->next = n;
     }
+    b_t->first = level[0];
+    b_t->length = len;
+
+    size_t target = b_fill_target_(fill, b_t->degree, (b_t->degree + 1) / 2);
+    for(size_t nlevel = nleaves; nlevel > 1; ) {
+        size_t nparents = b_group_count_(nlevel, target, b_t->degree);
+
+        // parents are written in place over the level of their children
+        for(size_t g = 0; g < nparents; g++) {
+            size_t begin = group_begin(nlevel, nparents, g),
+                   end = group_begin(nlevel, nparents, g + 1);
+            b_node* p = b_new_node_(b_t, 0);
+
+            p->nkeys = end - begin - 1;
+            p->children[0] = level[begin];
+            for(size_t i = 1; i < end - begin; i++) {
+                p->children[i] = level[begin + i];
+                memcpy(key_at(b_t, p, i - 1), lows[begin + i], szkey);
+            }
 
-    //// REBALANCING
-    b_node* procn = left_node(n, proc);
-
-    if(procn->entries->length < mindeg(b_t)) {
-        if(proc->prev && left_node(n, proc->prev)
-                ->entries->length > mindeg(b_t)) {
-            // rotate nodes from left sibling
-            ll_iter trans = proc->prev;
-            b_node* targetn = left_node(n, proc->prev);
-            ll_iter target = targetn->entries->tail->prev;
-
-            left_node(n, trans) = targetn->right;
-            targetn->right = left_node(targetn, target);
-            left_node(targetn, target) = targetn;
-
-            ll_move_bef(n->entries, targetn->entries,
-                    trans, target, 1);
-            ll_move_bef(procn->entries, n->entries,
-                    procn->entries->head, trans, 1);
-        } else if(proc->next && left_node(n, proc->next)
-                ->entries->length > mindeg(b_t)) {
-            // rotate nodes from right sibling
-            ll_iter trans = proc;
-            b_node* targetn = left_node(n, proc->next);
-            ll_iter target = targetn->entries->head;
-
-            left_node(n, trans) = procn->right;
-            procn->right = left_node(targetn, target);
-            left_node(targetn, target) = procn;
-
-            ll_move_bef(n->entries, targetn->entries,
-                    proc->next, target, 1);
-            ll_move_bef(procn->entries, n->entries,
-                    procn->entries->tail, trans, 1);
-        } else {
-            // sandwich: sink proc and merge proc with its left and right node
-            ll_iter pivot = NULL, suc = NULL;
-            if(proc->prev) { pivot = proc->prev; suc = proc; }
-            else { pivot = proc; suc = proc->next; }
-
-            b_node *leftn  = left_node(n, pivot),
-                   *rightn = left_node(n, suc);
-            left_node(n, pivot) = leftn->right;
-            leftn->right = rightn->right;
-            left_node(n, suc) = leftn;
-
-            ll_move_bef(leftn->entries, n->entries,
-                    leftn->entries->tail, pivot, 1);
-            ll_move_bef(leftn->entries, rightn->entries, leftn->entries->tail,
-                    rightn->entries->head, rightn->entries->length);
-
-            if(rightn->entries) ll_destroy(rightn->entries);
-            free(rightn);
+            lows[g] = lows[begin];
+            level[g] = p;
         }
+
+        nlevel = nparents;
     }
+
+    b_t->root = level[0];
+    b_t->version++;
+    free(lows);
+    free(level);
 }
 
-void b_unset(b_tree* b_t, void* key)
+ds_error b_try_get(b_tree* b_t, void* key, void** val)
 {
-    b_rotate_(b_t, b_t->root, key, NULL, NULL);
+    *val = b_get(b_t, key);
+    return *val ? DS_OK : DS_KEY_NOT_FOUND;
+}
 
-    if(b_t->root->entries->length == 0 && b_t->root->right) {
-        ll_destroy(b_t->root->entries);
-        b_node* new_root = b_t->root->right;
-        free(b_t->root);
-        b_t->root = new_root;
-    }
+ds_error b_try_unset(b_tree* b_t, void* key)
+{
+    if(!b_get(b_t, key)) return DS_KEY_NOT_FOUND;
+    b_unset(b_t, key);
+    return DS_OK;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Thread-safe Access
+
+int b_get_ts(b_tree* b_t, void* key, void* val)
+{
+    pthread_rwlock_rdlock(&b_t->lock);
+    void* v = b_get(b_t, key);
+    if(v) memcpy(val, v, b_t->val_size);
+    pthread_rwlock_unlock(&b_t->lock);
+
+    return v != NULL;
 }
 
+void b_set_ts(b_tree* b_t, void* key, void* val)
+{
+    pthread_rwlock_wrlock(&b_t->lock);
+    b_set(b_t, key, val);
+    pthread_rwlock_unlock(&b_t->lock);
+}
+
+int b_unset_ts(b_tree* b_t, void* key)
+{
+    pthread_rwlock_wrlock(&b_t->lock);
+    int found = b_try_unset(b_t, key) == DS_OK;
+    pthread_rwlock_unlock(&b_t->lock);
+
+    return found;
+}
@@ -6,20 +6,37 @@
 #define B_TREE_H_INCLUDED
 
 #include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
 
-#include "lnklist.h"
+#include "bintree.h"
 #include "utils.h"
+#include "varray.h"
+
+/*
+ * b_tree is a B+ tree. A node holds at most `degree - 1` keys in a sorted
+ * array, inline along with the values (leaves) or the `degree` children
+ * (internal nodes), all in one allocation. Entries live in leaves only, and
+ * leaves are doubly linked in key order. Keys in internal nodes are copies
+ * used for routing: keys in children[i] are in [keys[i-1], keys[i]).
+ */
 
 typedef comparator b_cmp;
 
 typedef struct b_node_t {
-    struct b_node_t* parentn;
-    struct b_node_t* right;
-    lnklist/*<b_entry>*/* entries;
+    size_t nkeys;
+    int leaf;
+    uint32_t key_size; // copied from the tree, for traversing a sub-tree
+    uint32_t val_size;
+    struct b_node_t* prev; // sibling leaves, NULL for internal nodes
+    struct b_node_t* next;
+    struct b_node_t** children; // internal nodes only
+    uint8_t* keys;
+    uint8_t* vals; // leaves only
 } b_node;
 
+// a view of a key-value pair, pointing into a node
 typedef struct b_entry_t {
-    b_node* left;
     uint8_t* key;
     uint8_t* val;
 } b_entry;
@@ -30,22 +47,86 @@ typedef struct b_tree_t_ {
     b_node* root;
     b_cmp cmp;
     size_t degree;
+    size_t length;
+    b_node* first; // leftmost leaf
+    size_t version; // bumped whenever entries are added or removed
+    pthread_rwlock_t lock; // taken by the _ts variants only
 } b_tree;
 
-typedef enum b_traverse_order_e {
-    lpr, plr, lrp,
-} b_traverse_order;
+/*
+ * A cursor walks entries in key order within [begin, end), one leaf after
+ * another. It remembers the last key it returned, so if the tree is modified
+ * between two steps, it seeks again from that key instead of following a
+ * stale leaf. Pages of a range can be read simply by resuming the cursor.
+ */
+typedef struct b_cursor_t_ {
+    b_tree* tree;
+    b_node* leaf;
+    size_t index;
+    size_t version;
+    int has_last; // whether `last` holds the begin or the last returned key
+    int past_last; // whether to resume after `last` rather than from it
+    int bounded; // whether `end` holds a key
+    uint8_t* last;
+    uint8_t* end;
+} b_cursor;
+
+/*
+ * lpr visits entries in key order. plr and lrp visit nodes in pre-order and
+ * post-order respectively, calling back on every key of a node, where routing
+ * keys of internal nodes come with a null val. Other orders are tossed as
+ * InvalidOrder. The orders are shared with bintree, so that both trees can be
+ * used in one translation unit. None of the traversals recurse, and lpr
+ * follows the leaf list with prefetching.
+ */
+typedef traverse_order b_traverse_order;
+
+#define B_BATCH 64
 
 b_tree* b_create_(size_t degree, size_t szkey, size_t szval, b_cmp cmp);
 void b_destroy(b_tree* b_t);
 void b_traverse(b_node* n, b_traverse_order to,
     void (*cb) (b_entry*, void*), void* usr);
+// the same order, handing over entries in blocks of up to B_BATCH
+void b_traverse_batch(b_node* n, b_traverse_order to,
+    void (*cb) (b_entry*, size_t, void*), void* usr);
 
 void* b_get(b_tree* b_t, void* key);
 void b_set(b_tree* b_t, void* key, void* val);
 void b_unset(b_tree* b_t, void* key);
+// error code variants, see exception.h
+ds_error b_try_get(b_tree* b_t, void* key, void** val);
+ds_error b_try_unset(b_tree* b_t, void* key);
+
+/*
+ * Thread-safe variants, which let any number of readers in at a time but
+ * writers only alone. b_get_ts copies the value out, since the leaf may be
+ * split or merged once the lock is released. b_get_ts and b_unset_ts return
+ * whether the key was found.
+ */
+int b_get_ts(b_tree* b_t, void* key, void* val);
+void b_set_ts(b_tree* b_t, void* key, void* val);
+int b_unset_ts(b_tree* b_t, void* key);
+
+/*
+ * Build the tree bottom-up in O(n) from `sorted`, whose elements are keys
+ * immediately followed by values, in strictly increasing order of keys. Nodes
+ * are filled to about `fill` (0, 1] of their capacity, so that later
+ * insertions have room before splitting. The tree must be empty.
+ */
+void b_bulk_load(b_tree* b_t, varray* sorted, double fill);
+
+// a null begin or end stands for no bound on that side
+int b_lower_bound(b_tree* b_t, void const* key, b_entry* e);
+size_t b_range(b_tree* b_t, void const* begin, void const* end,
+    void (*cb) (b_entry*, void*), void* usr);
+b_cursor* b_cursor_open(b_tree* b_t, void const* begin, void const* end);
+int b_cursor_next(b_cursor* c, b_entry* e);
+void b_cursor_close(b_cursor* c);
 
 #define b_create(degree, ktype, vtype, cmp) \
     b_create_(degree, sizeof(ktype), sizeof(vtype), cmp)
+#define b_key(b_t, n, i) ((n)->keys + (i) * (b_t)->key_size)
+#define b_val(b_t, n, i) ((n)->vals + (i) * (b_t)->val_size)
 
 #endif // B_TREE_H_INCLUDED
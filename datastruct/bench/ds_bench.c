@@ -0,0 +1,319 @@
+// cflags: varray.c vasort.c thrpool.c vaheap.c lnklist.c mempool.c bintree.c avltree.c b_tree.c hashmap.c graph.c dset.c csr.c exception.c utils.c -O2 -pthread
+
+/*
+ * Usage: ds_bench [max_n]
+ *
+ * Measures insertion, lookup, deletion and traversal of the containers with
+ * 1K, 10K, ... up to max_n (100K by default) int keys, fed in sequential,
+ * reverse and random order, then runs Dijkstra, Prim and Kruskal on random
+ * graphs (8 edges per node in average) and on grids of the same sizes.
+ *
+ * Every run prints one line, `<structure> <operation> <order> <n> <seconds>
+ * <million ops per second>`, where graph algorithms count edges as ops.
+ * Small sizes are repeated until about REPEAT_OPS ops are done, and seconds
+ * are the total of all repetitions. Lines starting with # are comments.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../varray.h"
+#include "../lnklist.h"
+#include "../avltree.h"
+#include "../b_tree.h"
+#include "../hashmap.h"
+#include "../graph.h"
+
+#define REPEAT_OPS 1000000
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t rand_state = 88172645463325252ULL;
+static uint64_t next_rand()
+{
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 7;
+    rand_state ^= rand_state << 17;
+    return rand_state;
+}
+
+static void report(char const* name, char const* op, char const* order,
+        size_t n, double t, size_t ops)
+{
+    printf("%s %s %s %lu %.6f %.3f\n", name, op, order, n, t, ops / t / 1e6);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Containers
+
+typedef enum { OP_INSERT, OP_LOOKUP, OP_DELETE, OP_TRAVERSE, NOPS } op_kind;
+static char const* op_names[NOPS] = { "insert", "lookup", "delete", "traverse" };
+
+// a checksum of everything read, which keeps loops from being optimized out
+static uint64_t checksum;
+
+static void sum_avl(btnode* n, void* usr)
+{ checksum += *(int*)entryof(n)->val; }
+static void sum_b(b_entry* e, void* usr)
+{ checksum += *(int*)e->val; }
+static void sum_hm(void* key, void* val, void* usr)
+{ checksum += *(int*)val; }
+
+// keys, a permutation of [0, n), are inserted and looked up in that order
+static void bench_varray(int* keys, size_t n, double* t)
+{
+    varray* va = va_create(int);
+    double t0 = now();
+    for(size_t i = 0; i < n; i++)
+        va_append(va, keys + i);
+    t[OP_INSERT] += now() - t0;
+
+    t0 = now();
+    for(size_t i = 0; i < n; i++)
+        checksum += *(int*)va_at(va, keys[i]);
+    t[OP_LOOKUP] += now() - t0;
+
+    t0 = now();
+    int* data = va_cast(int, va);
+    for(size_t i = 0; i < n; i++)
+        checksum += data[i];
+    t[OP_TRAVERSE] += now() - t0;
+
+    // from the tail, since removal in the middle is O(n) anyway
+    t0 = now();
+    for(size_t i = 0; i < n; i++)
+        va_remove(va, va->length - 1);
+    t[OP_DELETE] += now() - t0;
+    va_destroy(va);
+}
+
+// lists have no keyed lookup, so lookups are left out
+static void bench_lnklist(int* keys, size_t n, double* t)
+{
+    lnklist* ll = ll_create_pooled(int, NULL);
+    double t0 = now();
+    for(size_t i = 0; i < n; i++)
+        ll_append(ll, keys + i);
+    t[OP_INSERT] += now() - t0;
+
+    t0 = now();
+    for(ll_iter i = ll->head; !ll_is_end(i); i = i->next)
+        checksum += *(int*)i->data;
+    t[OP_TRAVERSE] += now() - t0;
+
+    t0 = now();
+    for(size_t i = 0; i < n; i++)
+        ll_remove(ll, ll->head);
+    t[OP_DELETE] += now() - t0;
+    ll_destroy(ll);
+}
+
+static void bench_avltree(int* keys, size_t n, double* t)
+{
+    bintree* avl = avl_create(int, int, cmpi);
+    double t0 = now();
+    for(size_t i = 0; i < n; i++)
+        avl_set(avl, keys + i, keys + i);
+    t[OP_INSERT] += now() - t0;
+
+    t0 = now();
+    for(size_t i = 0; i < n; i++)
+        checksum += *(int*)avl_get(avl, keys + i, NULL);
+    t[OP_LOOKUP] += now() - t0;
+
+    t0 = now();
+    bt_traverse(avl->root, lpr, sum_avl, NULL);
+    t[OP_TRAVERSE] += now() - t0;
+
+    t0 = now();
+    for(size_t i = 0; i < n; i++)
+        avl_unset(avl, keys + i);
+    t[OP_DELETE] += now() - t0;
+    avl_destroy(avl);
+}
+
+static void bench_b_tree(int* keys, size_t n, double* t)
+{
+    b_tree* b_t = b_create(32, int, int, cmpi);
+    double t0 = now();
+    for(size_t i = 0; i < n; i++)
+        b_set(b_t, keys + i, keys + i);
+    t[OP_INSERT] += now() - t0;
+
+    t0 = now();
+    for(size_t i = 0; i < n; i++)
+        checksum += *(int*)b_get(b_t, keys + i);
+    t[OP_LOOKUP] += now() - t0;
+
+    t0 = now();
+    b_traverse(b_t->root, lpr, sum_b, NULL);
+    t[OP_TRAVERSE] += now() - t0;
+
+    t0 = now();
+    for(size_t i = 0; i < n; i++)
+        b_unset(b_t, keys + i);
+    t[OP_DELETE] += now() - t0;
+    b_destroy(b_t);
+}
+
+static void bench_hashmap(int* keys, size_t n, double* t)
+{
+    hashmap* hm = hm_create(int, int, hashi, cmpi);
+    double t0 = now();
+    for(size_t i = 0; i < n; i++)
+        hm_set(hm, keys + i, keys + i);
+    t[OP_INSERT] += now() - t0;
+
+    t0 = now();
+    for(size_t i = 0; i < n; i++)
+        checksum += *(int*)hm_get(hm, keys + i);
+    t[OP_LOOKUP] += now() - t0;
+
+    t0 = now();
+    hm_traverse(hm, sum_hm, NULL);
+    t[OP_TRAVERSE] += now() - t0;
+
+    t0 = now();
+    for(size_t i = 0; i < n; i++)
+        hm_unset(hm, keys + i);
+    t[OP_DELETE] += now() - t0;
+    hm_destroy(hm);
+}
+
+typedef struct bench_entry_t_ {
+    char const* name;
+    void (*run) (int* keys, size_t n, double* t);
+    int has_lookup;
+} bench_entry;
+
+static bench_entry benches[] = {
+    { "varray", bench_varray, 1 },
+    { "lnklist", bench_lnklist, 0 },
+    { "avltree", bench_avltree, 1 },
+    { "b_tree", bench_b_tree, 1 },
+    { "hashmap", bench_hashmap, 1 },
+};
+
+static void bench_containers(size_t n)
+{
+    char const* orders[] = { "seq", "rev", "rand" };
+    int* keys = (int*) malloc(n * sizeof(int));
+    size_t reps = n < REPEAT_OPS ? REPEAT_OPS / n : 1;
+
+    for(int o = 0; o < 3; o++) {
+        for(size_t i = 0; i < n; i++)
+            keys[i] = o == 1 ? (int)(n - 1 - i) : (int)i;
+        if(o == 2)
+            for(size_t i = n - 1; i > 0; i--) {
+                size_t j = next_rand() % (i + 1);
+                int k = keys[i]; keys[i] = keys[j]; keys[j] = k;
+            }
+
+        for(size_t b = 0; b < sizeof(benches) / sizeof(bench_entry); b++) {
+            double t[NOPS] = { 0 };
+            for(size_t r = 0; r < reps; r++)
+                benches[b].run(keys, n, t);
+            for(int op = 0; op < NOPS; op++)
+                if(op != OP_LOOKUP || benches[b].has_lookup)
+                    report(benches[b].name, op_names[op], orders[o],
+                            n, t[op], n * reps);
+        }
+    }
+
+    free(keys);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Graphs
+
+// a ring keeps the graph connected, the rest of the edges are random
+static graph* random_graph(size_t n, gnode** nodes)
+{
+    graph* g = g_create(size_t, UNDIRECTED);
+    for(size_t i = 0; i < n; i++)
+        nodes[i] = g_add_node(g, &i);
+    for(size_t i = 0; i < n * 4; i++)
+        g_connect(g, nodes[i < n ? i : next_rand() % n],
+                nodes[i < n ? (i + 1) % n : next_rand() % n],
+                (int)(next_rand() % 1000) + 1);
+    return g;
+}
+
+// nodes of a side x side grid linked to their right and lower neighbours
+static graph* grid_graph(size_t side, gnode** nodes)
+{
+    graph* g = g_create(size_t, UNDIRECTED);
+    for(size_t i = 0; i < side * side; i++)
+        nodes[i] = g_add_node(g, &i);
+    for(size_t y = 0; y < side; y++)
+        for(size_t x = 0; x < side; x++) {
+            gnode* n = nodes[y * side + x];
+            if(x + 1 < side) g_connect(g, n, nodes[y * side + x + 1],
+                    (int)(next_rand() % 1000) + 1);
+            if(y + 1 < side) g_connect(g, n, nodes[(y + 1) * side + x],
+                    (int)(next_rand() % 1000) + 1);
+        }
+    return g;
+}
+
+static void bench_graph(graph* g, gnode* sp, gnode* ep,
+        char const* kind, size_t n)
+{
+    size_t m = g->edges->length;
+
+    double t = now();
+    checksum += g_dijkstra(g, sp, ep, NULL);
+    report("graph", "dijkstra", kind, n, now() - t, m);
+
+    graph* st = g_create(gnode*, UNDIRECTED);
+    t = now();
+    g_prim(g, st);
+    report("graph", "prim", kind, n, now() - t, m);
+    checksum += st->edges->length;
+    g_destroy(st);
+
+    st = g_create(gnode*, UNDIRECTED);
+    t = now();
+    g_kruskal(g, st);
+    report("graph", "kruskal", kind, n, now() - t, m);
+    checksum += st->edges->length;
+    g_destroy(st);
+}
+
+static void bench_graphs(size_t n)
+{
+    gnode** nodes = (gnode**) malloc(n * sizeof(gnode*));
+
+    graph* g = random_graph(n, nodes);
+    bench_graph(g, nodes[0], nodes[n / 2], "random", n);
+    g_destroy(g);
+
+    size_t side = 1;
+    while((side + 1) * (side + 1) <= n) side++;
+    g = grid_graph(side, nodes);
+    // from a corner to the opposite one
+    bench_graph(g, nodes[0], nodes[side * side - 1], "grid", side * side);
+    g_destroy(g);
+
+    free(nodes);
+}
+
+int main(int argc, char** argv)
+{
+    size_t max_n = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+
+    printf("# structure operation order n seconds mops\n");
+    for(size_t n = 1000; n <= max_n; n *= 10)
+        bench_containers(n);
+    for(size_t n = 1000; n <= max_n; n *= 10)
+        bench_graphs(n);
+
+    fprintf(stderr, "checksum %lu\n", (unsigned long)checksum);
+}
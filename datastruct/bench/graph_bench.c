@@ -0,0 +1,146 @@
+// cflags: lnklist.c mempool.c varray.c vasort.c thrpool.c vaheap.c exception.c graph.c dset.c csr.c utils.c -O2 -pthread
+
+/*
+ * Usage: graph_bench [max_nodes [avg_degree]]
+ *
+ * Builds random undirected graphs of 1K, 10K, ... up to max_nodes (100K by
+ * default) nodes with avg_degree (8 by default) edges per node in average,
+ * and runs traversals on the graph and on its csr snapshot, printing one line
+ * per run: <algorithm> <nodes> <edges> <seconds>, followed by the number of
+ * threads for parallel algorithms.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../graph.h"
+#include "../csr.h"
+#include "../thrpool.h"
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t rand_state = 88172645463325252ULL;
+static uint64_t next_rand()
+{
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 7;
+    rand_state ^= rand_state << 17;
+    return rand_state;
+}
+
+static size_t visited;
+static void count_node(gnode* n, void* usr) { visited++; }
+static void count_index(size_t i, void* usr) { visited++; }
+
+static long total_weight(graph* st)
+{
+    long w = 0;
+    for(ll_iter i = st->edges->head; !ll_is_end(i); i = i->next)
+        w += ((gedge*)i->data)->weight;
+    return w;
+}
+
+#define report(name, n, m, t) \
+    printf("%-16s %lu %lu %.4f\n", name, n, m, now() - (t))
+
+int main(int argc, char** argv)
+{
+    size_t max_n = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+    size_t degree = argc > 2 ? strtoul(argv[2], NULL, 10) : 8;
+
+    for(size_t n = 1000; n <= max_n; n *= 10) {
+        size_t m = n * degree / 2;
+        graph* g = g_create(int, UNDIRECTED);
+        gnode** nodes = (gnode**) malloc(n * sizeof(gnode*));
+
+        for(size_t i = 0; i < n; i++)
+            nodes[i] = g_add_node(g, &i);
+        // a ring keeps it connected, the rest are random
+        for(size_t i = 0; i < m; i++)
+            g_connect(g, nodes[i < n ? i : next_rand() % n],
+                    nodes[i < n ? (i + 1) % n : next_rand() % n],
+                    (int)(next_rand() % 1000) + 1);
+
+        double t = now();
+        csr* c = g_freeze(g);
+        report("g_freeze", n, m, t);
+        // node indices are lost in rsrv once graph algorithms run
+        size_t sp = csr_index(nodes[0]), ep = csr_index(nodes[n / 2]);
+
+        t = now();
+        g_dfs(g, nodes[0], count_node, NULL);
+        report("g_dfs", n, m, t);
+        t = now();
+        csr_dfs(c, sp, count_index, NULL);
+        report("csr_dfs", n, m, t);
+
+        int* hops = (int*) malloc(n * sizeof(int));
+        t = now();
+        csr_bfs(c, sp, hops);
+        report("csr_bfs", n, m, t);
+        for(size_t th = 1; th <= tp_ncpus(); th *= 2) {
+            t = now();
+            csr_bfs_parallel(c, sp, hops, th);
+            printf("%-16s %lu %lu %.4f %lu threads\n", "csr_bfs_parallel",
+                    n, m, now() - t, th);
+        }
+        uint32_t* labels = (uint32_t*) malloc(n * sizeof(uint32_t));
+        for(size_t th = 1; th <= tp_ncpus(); th *= 2) {
+            t = now();
+            csr_components(c, labels, th);
+            printf("%-16s %lu %lu %.4f %lu threads\n", "csr_components",
+                    n, m, now() - t, th);
+        }
+        free(labels);
+        free(hops);
+
+        t = now();
+        int d1 = g_dijkstra(g, nodes[0], nodes[n / 2], NULL);
+        report("g_dijkstra", n, m, t);
+        t = now();
+        int d3 = g_bidijkstra(g, nodes[0], nodes[n / 2], NULL);
+        report("g_bidijkstra", n, m, t);
+        if(d1 != d3) printf("distances differ: %d vs %d\n", d1, d3);
+        t = now();
+        int d2 = csr_dijkstra(c, sp, ep, NULL);
+        report("csr_dijkstra", n, m, t);
+        if(d1 != d2) printf("distances differ: %d vs %d\n", d1, d2);
+
+        graph* st = g_create(gnode*, UNDIRECTED);
+        t = now();
+        g_prim(g, st);
+        report("g_prim", n, m, t);
+        g_destroy(st);
+
+        st = g_create(gnode*, UNDIRECTED);
+        t = now();
+        g_kruskal(g, st);
+        report("g_kruskal", n, m, t);
+        long w1 = total_weight(st);
+        g_destroy(st);
+        for(size_t th = 1; th <= tp_ncpus(); th *= 2) {
+            st = g_create(gnode*, UNDIRECTED);
+            t = now();
+            g_boruvka(g, st, th);
+            printf("%-16s %lu %lu %.4f %lu threads\n", "g_boruvka",
+                    n, m, now() - t, th);
+            if(total_weight(st) != w1)
+                printf("weights differ: %ld vs %ld\n", w1, total_weight(st));
+            g_destroy(st);
+        }
+        t = now();
+        csr_mst(c, NULL);
+        report("csr_mst", n, m, t);
+
+        csr_destroy(c);
+        free(nodes);
+        g_destroy(g);
+    }
+}
@@ -0,0 +1,98 @@
+// cflags: hashmap.c bintree.c mempool.c avltree.c b_tree.c varray.c exception.c utils.c -O2 -pthread
+
+/*
+ * Usage: hash_bench [n]
+ *
+ * Inserts n (1M by default) random int keys into a hashmap, an avltree and a
+ * b_tree, then looks up n keys, half of which are missing, printing one line
+ * per phase: <structure> <operation> <n> <million ops per second>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../hashmap.h"
+#include "../avltree.h"
+#include "../b_tree.h"
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t next_rand(uint64_t* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static void report(char const* name, char const* op, size_t n, double t)
+{
+    printf("%-8s %-6s %lu %.3f\n", name, op, n, n / t / 1e6);
+}
+
+int main(int argc, char** argv)
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    uint64_t state = 88172645463325252ULL;
+
+    // even keys are inserted, odd keys are missing
+    int* keys = (int*) malloc(n * sizeof(int));
+    int* probes = (int*) malloc(n * sizeof(int));
+    for(size_t i = 0; i < n; i++)
+        keys[i] = (int)(next_rand(&state) & 0x3ffffffe);
+    for(size_t i = 0; i < n; i++)
+        probes[i] = i % 2 ? keys[next_rand(&state) % n] :
+            (int)(next_rand(&state) & 0x3ffffffe) + 1;
+
+    hashmap* hm = hm_create(int, int, hashi, cmpi);
+    bintree* avl = avl_create(int, int, cmpi);
+    b_tree* b_t = b_create(32, int, int, cmpi);
+    size_t found = 0;
+    double t;
+
+    t = now();
+    for(size_t i = 0; i < n; i++)
+        hm_set(hm, keys + i, keys + i);
+    report("hashmap", "set", n, now() - t);
+
+    t = now();
+    for(size_t i = 0; i < n; i++)
+        avl_set(avl, keys + i, keys + i);
+    report("avltree", "set", n, now() - t);
+
+    t = now();
+    for(size_t i = 0; i < n; i++)
+        b_set(b_t, keys + i, keys + i);
+    report("b_tree", "set", n, now() - t);
+
+    t = now();
+    for(size_t i = 0; i < n; i++)
+        found += hm_get(hm, probes + i) != NULL;
+    report("hashmap", "get", n, now() - t);
+
+    t = now();
+    for(size_t i = 0; i < n; i++)
+        found += avl_get(avl, probes + i, NULL) != NULL;
+    report("avltree", "get", n, now() - t);
+
+    t = now();
+    for(size_t i = 0; i < n; i++)
+        found += b_get(b_t, probes + i) != NULL;
+    report("b_tree", "get", n, now() - t);
+
+    // keep the lookups from being optimized out
+    fprintf(stderr, "%lu found\n", found);
+
+    b_destroy(b_t);
+    avl_destroy(avl);
+    hm_destroy(hm);
+    free(probes);
+    free(keys);
+}
@@ -0,0 +1,86 @@
+// cflags: exception.c varray.c vasort.c vaheap.c utils.c -O2
+
+/*
+ * Usage: heap_bench [n [k]]
+ *
+ * Builds a heap of n (10M by default) pseudo-random integers by inserting
+ * them one by one, by va_heap_push_n and by va_heapify, and picks the k
+ * (100 by default) greatest by va_topk, each next to a full va_introsort of
+ * the same input. Prints one line per run: <operation> <n> <seconds>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../varray.h"
+#include "../vaheap.h"
+#include "../vasort.h"
+#include "../utils.h"
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t next_rand(uint64_t* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+int main(int argc, char** argv)
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000000;
+    size_t k = argc > 2 ? strtoul(argv[2], NULL, 10) : 100;
+    uint64_t state = 88172645463325252ULL;
+    va_cmp cmp = (va_cmp)cmpi;
+
+    int* input = (int*) malloc(n * sizeof(int));
+    for(size_t i = 0; i < n; i++)
+        input[i] = (int)(next_rand(&state) >> 33);
+
+    varray* va = va_create(int);
+    double t = now();
+    for(size_t i = 0; i < n; i++)
+        va_heap_insert(va, cmp, input + i);
+    printf("heap_insert %lu %.4f\n", n, now() - t);
+    va_destroy(va);
+
+    va = va_create(int);
+    t = now();
+    va_heap_push_n(va, cmp, input, n);
+    printf("heap_push_n %lu %.4f\n", n, now() - t);
+    va_destroy(va);
+
+    va = va_create(int);
+    va_append_n(va, input, n);
+    t = now();
+    va_heapify(va, cmp);
+    printf("heapify     %lu %.4f\n", n, now() - t);
+
+    t = now();
+    va_heap_sort(va, cmp);
+    printf("heap_sort   %lu %.4f\n", n, now() - t);
+    va_destroy(va);
+
+    va = va_create(int);
+    t = now();
+    va_topk(va, cmp, k, input, n);
+    printf("topk        %lu %.4f\n", n, now() - t);
+    va_destroy(va);
+
+    va = va_create(int);
+    va_append_n(va, input, n);
+    t = now();
+    va_introsort(va, cmp);
+    printf("introsort   %lu %.4f\n", n, now() - t);
+    va_destroy(va);
+
+    free(input);
+}
@@ -0,0 +1,72 @@
+// cflags: exception.c varray.c vasort.c vapsort.c thrpool.c utils.c -O2 -pthread
+
+/*
+ * Usage: psort_bench [max_n [max_threads]]
+ *
+ * Sorts 1M, 10M, ... up to max_n (100M by default) pseudo-random integers
+ * with va_sort_parallel on 1, 2, 4, ... threads, printing one line per run:
+ * <algorithm> <n> <threads> <seconds>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../varray.h"
+#include "../vasort.h"
+#include "../vapsort.h"
+#include "../thrpool.h"
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int int_cmp(void* l, void* r)
+{
+    int a = *(int*)l, b = *(int*)r;
+    return a < b ? -1 : a > b;
+}
+
+static uint64_t rand_state = 88172645463325252ULL;
+static uint64_t next_rand()
+{
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 7;
+    rand_state ^= rand_state << 17;
+    return rand_state;
+}
+
+int main(int argc, char** argv)
+{
+    size_t max_n = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000000;
+    size_t max_threads = argc > 2 ? strtoul(argv[2], NULL, 10) : tp_ncpus();
+
+    for(size_t n = 1000000; n <= max_n; n *= 10) {
+        varray* orig = va_create(int);
+        va_append_n(orig, NULL, n);
+        for(size_t i = 0; i < n; i++)
+            va_cast(int, orig)[i] = (int)next_rand();
+        varray* va = va_create(int);
+        va_append_n(va, NULL, n);
+
+        memcpy(va->data, orig->data, n * sizeof(int));
+        double t = now();
+        va_introsort(va, int_cmp);
+        printf("%-16s %lu %lu %.3f\n", "introsort", n, 1UL, now() - t);
+
+        for(size_t th = 1; th <= max_threads; th *= 2) {
+            memcpy(va->data, orig->data, n * sizeof(int));
+            t = now();
+            va_sort_parallel(va, int_cmp, th);
+            printf("%-16s %lu %lu %.3f\n", "sort_parallel", n, th, now() - t);
+        }
+
+        va_destroy(va);
+        va_destroy(orig);
+    }
+}
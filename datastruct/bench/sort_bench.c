@@ -0,0 +1,99 @@
+// cflags: exception.c varray.c vasort.c utils.c -O2
+
+/*
+ * Usage: sort_bench [n]
+ *
+ * Sorts n (10M by default) pseudo-random integers with each algorithm and
+ * prints one line per run: <algorithm> <n> <seconds>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../varray.h"
+#include "../vasort.h"
+#include "../utils.h"
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int int_cmp(void* l, void* r)
+{
+    int a = *(int*)l, b = *(int*)r;
+    return a < b ? -1 : a > b;
+}
+
+static int int64_cmp(void* l, void* r)
+{
+    int64_t a = *(int64_t*)l, b = *(int64_t*)r;
+    return a < b ? -1 : a > b;
+}
+
+static int cmpi_qsort(void const* l, void const* r)
+{
+    int32_t a = *(int32_t const*)l, b = *(int32_t const*)r;
+    return a < b ? -1 : a > b;
+}
+
+static int cmpi64_qsort(void const* l, void const* r)
+{
+    int64_t a = *(int64_t const*)l, b = *(int64_t const*)r;
+    return a < b ? -1 : a > b;
+}
+
+static uint64_t rand_state = 88172645463325252ULL;
+static uint64_t next_rand()
+{
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 7;
+    rand_state ^= rand_state << 17;
+    return rand_state;
+}
+
+#define bench(name, va, orig, sort) { \
+    memcpy((va)->data, (orig)->data, (orig)->length * (orig)->elem_size); \
+    double t = now(); \
+    sort; \
+    printf("%-16s %lu %.3f\n", name, (size_t)(va)->length, now() - t); \
+}
+
+int main(int argc, char** argv)
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000000;
+
+    varray* orig = va_create(int32_t);
+    va_append_n(orig, NULL, n);
+    for(size_t i = 0; i < n; i++)
+        va_cast(int32_t, orig)[i] = (int32_t)next_rand();
+    varray* va = va_create(int32_t);
+    va_append_n(va, NULL, n);
+
+    bench("qsort", va, orig, qsort(va->data, n, sizeof(int32_t), cmpi_qsort));
+    bench("introsort", va, orig, va_introsort(va, int_cmp));
+    bench("stable", va, orig, va_sort_stable(va, int_cmp));
+    bench("radix_i32", va, orig, va_radix_sort_i32(va));
+    bench("va_sort(cmpi)", va, orig, va_sort(va, (va_cmp)cmpi));
+    va_destroy(va);
+    va_destroy(orig);
+
+    orig = va_create(int64_t);
+    va_append_n(orig, NULL, n);
+    for(size_t i = 0; i < n; i++)
+        va_cast(int64_t, orig)[i] = (int64_t)next_rand();
+    va = va_create(int64_t);
+    va_append_n(va, NULL, n);
+
+    bench("qsort_i64", va, orig,
+            qsort(va->data, n, sizeof(int64_t), cmpi64_qsort));
+    bench("introsort_i64", va, orig, va_introsort(va, int64_cmp));
+    bench("stable_i64", va, orig, va_sort_stable(va, int64_cmp));
+    bench("radix_i64", va, orig, va_radix_sort_i64(va));
+    va_destroy(va);
+    va_destroy(orig);
+}
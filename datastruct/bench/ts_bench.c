@@ -0,0 +1,114 @@
+// cflags: bintree.c mempool.c avltree.c b_tree.c varray.c exception.c utils.c -O2 -pthread
+
+/*
+ * Usage: ts_bench [n [max_threads [read_percent]]]
+ *
+ * Loads n (1M by default) keys into an avltree and a b_tree, then runs a mix
+ * of lookups and updates (95% lookups by default) on 1, 2, 4, ... threads
+ * through the thread-safe variants, printing one line per run:
+ * <structure> <n> <threads> <read_percent> <million ops per second>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../avltree.h"
+#include "../b_tree.h"
+
+#define OPS_PER_THREAD 1000000
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t next_rand(uint64_t* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+typedef struct worker_arg_t_ {
+    void* tree;
+    int is_avl;
+    size_t n;
+    int read_percent;
+    uint64_t seed;
+} worker_arg;
+
+static void* worker(void* usr)
+{
+    worker_arg* arg = (worker_arg*)usr;
+    uint64_t state = arg->seed;
+
+    for(size_t i = 0; i < OPS_PER_THREAD; i++) {
+        uint64_t r = next_rand(&state);
+        int k = (int)(r % arg->n), v = (int)(r >> 32);
+        int read = (int)(r >> 40) % 100 < arg->read_percent;
+
+        if(arg->is_avl) {
+            if(read) avl_get_ts((bintree*)arg->tree, &k, &v);
+            else avl_set_ts((bintree*)arg->tree, &k, &v);
+        } else {
+            if(read) b_get_ts((b_tree*)arg->tree, &k, &v);
+            else b_set_ts((b_tree*)arg->tree, &k, &v);
+        }
+    }
+
+    return NULL;
+}
+
+static void run(char const* name, void* tree, int is_avl,
+        size_t n, size_t nthreads, int read_percent)
+{
+    pthread_t* threads = (pthread_t*) malloc(nthreads * sizeof(pthread_t));
+    worker_arg* args = (worker_arg*) malloc(nthreads * sizeof(worker_arg));
+
+    double t = now();
+    for(size_t i = 0; i < nthreads; i++) {
+        worker_arg a = { tree, is_avl, n, read_percent, 88172645463325252ULL + i };
+        args[i] = a;
+        pthread_create(threads + i, NULL, worker, args + i);
+    }
+    for(size_t i = 0; i < nthreads; i++)
+        pthread_join(threads[i], NULL);
+    t = now() - t;
+
+    printf("%-8s %lu %lu %d %.3f\n", name, n, nthreads, read_percent,
+            nthreads * OPS_PER_THREAD / t / 1e6);
+    free(args);
+    free(threads);
+}
+
+int main(int argc, char** argv)
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_threads = argc > 2 ? strtoul(argv[2], NULL, 10) :
+        ncpus > 0 ? (size_t)ncpus : 1;
+    int read_percent = argc > 3 ? atoi(argv[3]) : 95;
+
+    bintree* avl = avl_create(int, int, cmpi);
+    b_tree* b_t = b_create(32, int, int, cmpi);
+    for(size_t i = 0; i < n; i++) {
+        int k = (int)i;
+        avl_set(avl, &k, &k);
+        b_set(b_t, &k, &k);
+    }
+
+    for(size_t th = 1; th <= max_threads; th *= 2) {
+        run("avltree", avl, 1, n, th, read_percent);
+        run("b_tree", b_t, 0, n, th, read_percent);
+    }
+
+    b_destroy(b_t);
+    avl_destroy(avl);
+}
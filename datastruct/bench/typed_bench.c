@@ -0,0 +1,129 @@
+// cflags: bintree.c mempool.c avltree.c varray.c vasort.c exception.c utils.c -O2 -pthread
+
+/*
+ * Usage: typed_bench [n]
+ *
+ * Runs the same work on the generic containers and on their VA_DEFINE and
+ * AVL_DEFINE specializations: appending, summing and introsorting n (10M by
+ * default) int64 keys, then setting and getting n / 10 random int keys in an
+ * AVL map. Prints one line per run: <container> <operation> <n> <seconds>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../varray.h"
+#include "../vasort.h"
+#include "../avltree.h"
+#include "../vatyped.h"
+#include "../avltyped.h"
+
+VA_DEFINE(va_int64, int64_t, cmp_num)
+AVL_DEFINE(avl_int_int, int, int, cmp_num)
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t next_rand(uint64_t* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static void report(char const* name, char const* op, size_t n, double t)
+{
+    printf("%-12s %-6s %lu %.4f\n", name, op, n, t);
+}
+
+int main(int argc, char** argv)
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000000;
+    uint64_t state = 88172645463325252ULL;
+    uint64_t sum = 0;
+    double t;
+
+    ////////////////////////////////////////////// varray
+
+    varray* va = va_create(int64_t);
+    t = now();
+    for(size_t i = 0; i < n; i++) {
+        int64_t e = (int64_t)next_rand(&state);
+        va_append(va, &e);
+    }
+    report("varray", "append", n, now() - t);
+
+    t = now();
+    for(size_t i = 0; i < n; i++)
+        sum += *(uint64_t*)va_at(va, i);
+    report("varray", "at", n, now() - t);
+
+    t = now();
+    va_introsort(va, (va_cmp)cmpi64);
+    report("varray", "sort", n, now() - t);
+    va_destroy(va);
+
+    state = 88172645463325252ULL;
+    va_int64* tva = va_int64_create();
+    t = now();
+    for(size_t i = 0; i < n; i++)
+        va_int64_append(tva, (int64_t)next_rand(&state));
+    report("va_int64", "append", n, now() - t);
+
+    t = now();
+    for(size_t i = 0; i < n; i++)
+        sum += (uint64_t)*va_int64_at(tva, i);
+    report("va_int64", "at", n, now() - t);
+
+    t = now();
+    va_int64_sort(tva);
+    report("va_int64", "sort", n, now() - t);
+    va_int64_destroy(tva);
+
+    ////////////////////////////////////////////// avltree
+
+    size_t m = n / 10;
+    int* keys = (int*) malloc(m * sizeof(int));
+    for(size_t i = 0; i < m; i++)
+        keys[i] = (int)(next_rand(&state) % (m * 2));
+
+    bintree* avl = avl_create(int, int, cmpi);
+    t = now();
+    for(size_t i = 0; i < m; i++)
+        avl_set(avl, keys + i, keys + i);
+    report("avltree", "set", m, now() - t);
+
+    t = now();
+    for(size_t i = 0; i < m; i++) {
+        int k = (int)i;
+        int* v = (int*)avl_get(avl, &k, NULL);
+        if(v) sum += *v;
+    }
+    report("avltree", "get", m, now() - t);
+    avl_destroy(avl);
+
+    avl_int_int* tavl = avl_int_int_create();
+    t = now();
+    for(size_t i = 0; i < m; i++)
+        avl_int_int_set(tavl, keys[i], keys[i]);
+    report("avl_int_int", "set", m, now() - t);
+
+    t = now();
+    for(size_t i = 0; i < m; i++) {
+        int* v = avl_int_int_get(tavl, (int)i);
+        if(v) sum += *v;
+    }
+    report("avl_int_int", "get", m, now() - t);
+    avl_int_int_destroy(tavl);
+
+    // keep the reads from being optimized out
+    fprintf(stderr, "checksum %lu\n", (unsigned long)sum);
+    free(keys);
+}
@@ -7,12 +7,14 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "dsstat.h"
 #include "exception.h"
+#include "utils.h"
 
 btnode* bt_new_node(bintree* bt, void* data)
 {
-    btnode* n = (btnode*) malloc(sizeof(btnode) + bt->elem_size);
-    if(!n) toss(MemoryError);
+    btnode* n = (btnode*) mp_alloc(bt->pool);
+    ds_stat_alloc(DS_STAT_BINTREE, bt->pool->block_size);
 
     n->data = (uint8_t*)(n + 1);
     if(data) memcpy(n->data, data, bt->elem_size);
@@ -31,7 +33,8 @@ void bt_rm_node(bintree* bt, btnode* n)
     if(n->parent) bt_pfield(bt, n->parent, n) = NULL;
     if(bt->root == n) bt->root = NULL;
 
-    free(n);
+    mp_free(bt->pool, n);
+    ds_stat_free(DS_STAT_BINTREE);
 }
 
 bintree* bt_create_(size_t szelem, void* data)
@@ -39,6 +42,7 @@ bintree* bt_create_(size_t szelem, void* data)
     bintree* bt = (bintree*) malloc(sizeof(bintree));
     if(!bt) toss(MemoryError);
     bt->elem_size = szelem;
+    bt->pool = mp_create(sizeof(btnode) + szelem);
     if(data) bt->root = bt_new_node(bt, data);
     else bt->root = NULL;
     return bt;
@@ -58,32 +62,101 @@ btnode* bt_rchild(btnode* rt, btnode* n)
     return n;
 }
 
-void bt_traverse(btnode* n, traverse_order to,
-        void (*cb) (btnode*, void*), void* usr)
+////////////////////////////////////////////////////////////////////////////////
+// Traversal
+
+enum { task_self_, task_left_, task_right_ };
+
+typedef struct bt_frame_t_ {
+    btnode* node;
+    unsigned stage; // index of the next task
+} bt_frame_;
+
+// walk the subtree of n, calling either cb on every node or batch on blocks
+static void bt_walk_(btnode* n, traverse_order to,
+        void (*cb) (btnode*, void*),
+        void (*batch) (btnode**, size_t, void*), void* usr)
 {
     if(!n) return;
 
-    btnode* tasks[3] = { n, n->left, n->right };
+    unsigned tasks[3] = { task_self_, task_left_, task_right_ };
     for(unsigned i = to; i; i /= 4) {
         unsigned i1 = i % 4 - 1,
                  i2 = i % 4 - 2;
-        btnode* t = tasks[i1];
+        unsigned t = tasks[i1];
         tasks[i1] = tasks[i2];
         tasks[i2] = t;
     }
 
-    for(size_t i = 0; i < 3; i++) {
-        if(tasks[i] == n) cb(n, usr);
-        else bt_traverse(tasks[i], to, cb, usr);
+    // the stack is as deep as the tree, moved to the heap beyond 64
+    bt_frame_ local[64];
+    bt_frame_* stack = local;
+    size_t cap = 64, top = 0;
+    btnode* block[BT_BATCH];
+    size_t nblock = 0;
+
+    stack[top].node = n;
+    stack[top++].stage = 0;
+    ds_prefetch(n->left);
+    ds_prefetch(n->right);
+
+    while(top) {
+        bt_frame_* f = stack + top - 1;
+        if(f->stage == 3) {
+            top--;
+            continue;
+        }
+
+        btnode* t = f->node;
+        switch(tasks[f->stage++]) {
+            case task_self_:
+                if(!batch) cb(t, usr);
+                else {
+                    block[nblock++] = t;
+                    if(nblock == BT_BATCH) {
+                        batch(block, nblock, usr);
+                        nblock = 0;
+                    }
+                }
+                continue;
+            case task_left_: t = t->left; break;
+            case task_right_: t = t->right; break;
+        }
+        if(!t) continue;
+
+        if(top == cap) {
+            bt_frame_* s = (bt_frame_*)malloc(cap * 2 * sizeof(bt_frame_));
+            if(!s) toss(MemoryError);
+            memcpy(s, stack, cap * sizeof(bt_frame_));
+            if(stack != local) free(stack);
+            stack = s;
+            cap *= 2;
+        }
+        stack[top].node = t;
+        stack[top++].stage = 0;
+        // children are read as soon as t is done with
+        ds_prefetch(t->left);
+        ds_prefetch(t->right);
     }
+
+    if(nblock) batch(block, nblock, usr);
+    if(stack != local) free(stack);
 }
 
+void bt_traverse(btnode* n, traverse_order to,
+        void (*cb) (btnode*, void*), void* usr)
+{ bt_walk_(n, to, cb, NULL, usr); }
+
+void bt_traverse_batch(btnode* n, traverse_order to,
+        void (*cb) (btnode**, size_t, void*), void* usr)
+{ bt_walk_(n, to, NULL, cb, usr); }
+
 void bt_erase_node_(btnode* n, void* usr)
 { bt_rm_node((bintree*)usr, n); }
 void bt_destroy(bintree* bt)
 {
-    bt_traverse(bt->root, lrp, bt_erase_node_, bt);
-    // we have reason to believe that the root node has got freed
+    // nodes all come from the pool, no need to visit them one by one
+    mp_destroy(bt->pool);
     free(bt);
 }
 
@@ -8,6 +8,8 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include "mempool.h"
+
 typedef struct btnode_t_ {
     unsigned char* data;
     struct btnode_t_* left;
@@ -15,10 +17,13 @@ typedef struct btnode_t_ {
     struct btnode_t_* parent;
 } btnode;
 
+// a node and its data are one block from the tree's pool, which releases all
+// nodes at once on bt_destroy
 typedef struct bintree_t_ {
     size_t elem_size;
     btnode* root;
     void* reserved;
+    mempool* pool;
 } bintree;
 
 typedef enum child_order_e_ {
@@ -26,13 +31,14 @@ typedef enum child_order_e_ {
 } child_order;
 
 typedef enum traverse_order_e {
-    // quanternary: late - early
+    // quanternary digits, early ones lowest, each d swaps tasks d-1 and d-2
+    // of (p, l, r)
     plr = 0, // - : first-order
     lpr = 2, // 2 : inorder
     prl = 3, // 3
-    rpl = 6, // 12
+    rpl = 11,// 23
     lrp = 14,// 32 : postorder
-    rlp = 1, // 1
+    rlp = 59,// 323
 } traverse_order;
 
 // node->data is not be initialize if data is null
@@ -44,8 +50,16 @@ void bt_rm_node(bintree* bt, btnode* n);
 bintree* bt_create_(size_t szelem, void* data);
 btnode* bt_lchild(btnode* rt, btnode* n);
 btnode* bt_rchild(btnode* rt, btnode* n);
+/*
+ * Traversals walk an explicit stack instead of recursing, so degenerate trees
+ * of any height can be visited. bt_traverse_batch hands visited nodes over in
+ * blocks of up to BT_BATCH, in the same order as bt_traverse.
+ */
+#define BT_BATCH 64
 void bt_traverse(btnode* n, traverse_order to,
         void (*cb) (btnode*, void*), void* usr);
+void bt_traverse_batch(btnode* n, traverse_order to,
+        void (*cb) (btnode**, size_t, void*), void* usr);
 void bt_erase_node_(btnode* n, void* usr);
 void bt_destroy(bintree* bt);
 
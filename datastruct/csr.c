@@ -0,0 +1,518 @@
+/*
+ * Copyright(c) 2015, Shihira Fung <fengzhiping@hotmail.com>
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "csr.h"
+#include "vaheap.h"
+#include "thrpool.h"
+#include "exception.h"
+
+#define casti_node(i) ((gnode*)((i)->data))
+#define casti_edgep(i) (*(gedge**)((i)->data))
+
+static void* csr_alloc_(size_t n, size_t size)
+{
+    // keep a valid pointer even for an empty graph
+    void* p = malloc(n ? n * size : 1);
+    if(!p) toss(MemoryError);
+    return p;
+}
+
+// fill offsets, nbrs and weights from one adjacency list of every node
+static void csr_fill_(csr* c, int in, size_t** offsets,
+        uint32_t** nbrs, int** weights)
+{
+    size_t nadj = 0;
+
+    *offsets = (size_t*)csr_alloc_(c->nnodes + 1, sizeof(size_t));
+    for(size_t i = 0; i < c->nnodes; i++) {
+        gnode* n = c->nodes[i];
+        lnklist* adj = c->gtype == UNDIRECTED ? n->adj.undirected.bi :
+            in ? n->adj.directed.in : n->adj.directed.out;
+        (*offsets)[i] = nadj;
+        nadj += adj->length;
+    }
+    (*offsets)[c->nnodes] = nadj;
+
+    *nbrs = (uint32_t*)csr_alloc_(nadj, sizeof(uint32_t));
+    *weights = (int*)csr_alloc_(nadj, sizeof(int));
+    c->nadj = nadj;
+
+    for(size_t i = 0, k = 0; i < c->nnodes; i++) {
+        gnode* n = c->nodes[i];
+        lnklist* adj = c->gtype == UNDIRECTED ? n->adj.undirected.bi :
+            in ? n->adj.directed.in : n->adj.directed.out;
+
+        for(ll_iter j = adj->head; !ll_is_end(j); j = j->next, k++) {
+            gedge* e = casti_edgep(j);
+            (*nbrs)[k] = csr_index(g_endpoint(e, n));
+            (*weights)[k] = e->weight;
+        }
+    }
+}
+
+csr* g_freeze(graph* g)
+{
+    if(g->nodes->length > UINT32_MAX) toss(GraphTooLarge);
+
+    csr* c = (csr*)malloc(sizeof(csr));
+    if(!c) toss(MemoryError);
+    c->gtype = g->gtype;
+    c->nnodes = g->nodes->length;
+    c->nodes = (gnode**)csr_alloc_(c->nnodes, sizeof(gnode*));
+
+    size_t idx = 0;
+    for(ll_iter i = g->nodes->head; !ll_is_end(i); i = i->next, idx++) {
+        c->nodes[idx] = casti_node(i);
+        casti_node(i)->rsrv = (void*)(uintptr_t)idx;
+    }
+
+    csr_fill_(c, 0, &c->offsets, &c->nbrs, &c->weights);
+    if(c->gtype == DIRECTED)
+        csr_fill_(c, 1, &c->in_offsets, &c->in_nbrs, &c->in_weights);
+    else {
+        c->in_offsets = c->offsets;
+        c->in_nbrs = c->nbrs;
+        c->in_weights = c->weights;
+    }
+
+    return c;
+}
+
+void csr_destroy(csr* c)
+{
+    if(c->gtype == DIRECTED) {
+        free(c->in_offsets);
+        free(c->in_nbrs);
+        free(c->in_weights);
+    }
+    free(c->offsets);
+    free(c->nbrs);
+    free(c->weights);
+    free(c->nodes);
+    free(c);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Traversals
+
+void csr_dfs(csr* c, size_t sp, void (*cb) (size_t, void*), void* usr)
+{
+    uint8_t* visited = (uint8_t*)calloc(c->nnodes ? c->nnodes : 1, 1);
+    if(!visited) toss(MemoryError);
+    varray* s/*tack*/ = va_create(uint32_t);
+    uint32_t n = sp;
+    va_append(s, &n);
+
+    while(s->length) {
+        n = va_cast(uint32_t, s)[--s->length];
+        if(visited[n]) continue;
+
+        cb(n, usr);
+        visited[n] = 1;
+
+        size_t end = c->offsets[n + 1];
+        va_reserve(s, s->length + end - c->offsets[n]);
+        for(size_t i = c->offsets[n]; i < end; i++)
+            if(!visited[c->nbrs[i]])
+                va_cast(uint32_t, s)[s->length++] = c->nbrs[i];
+    }
+
+    va_destroy(s);
+    free(visited);
+}
+
+void csr_bfs(csr* c, size_t sp, int* hops)
+{
+    uint32_t* queue = (uint32_t*)csr_alloc_(c->nnodes, sizeof(uint32_t));
+    size_t head = 0, tail = 0;
+
+    for(size_t i = 0; i < c->nnodes; i++) hops[i] = -1;
+    hops[sp] = 0;
+    queue[tail++] = sp;
+
+    while(head < tail) {
+        uint32_t n = queue[head++];
+        for(size_t i = c->offsets[n]; i < c->offsets[n + 1]; i++) {
+            uint32_t m = c->nbrs[i];
+            if(hops[m] >= 0) continue;
+            hops[m] = hops[n] + 1;
+            queue[tail++] = m;
+        }
+    }
+
+    free(queue);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Dijkstra's Algorithm and Prim's Algorithm
+
+// Dijkstra's algorithm lowers distances in place in an indexed heap. Prim's
+// algorithm pushes a node again whenever a lighter edge reaches it, and skips
+// outdated entries when they come to the top.
+
+typedef struct csr_heap_entry_t_ {
+    int distance;
+    uint32_t n;
+    uint32_t src;
+} csr_heap_entry;
+
+static int csr_heap_cmp_(void* l, void* r)
+{
+    // minimum heap comparator
+    int dl = ((csr_heap_entry*)l)->distance,
+        dr = ((csr_heap_entry*)r)->distance;
+    return dl > dr ? -1 : dl < dr;
+}
+
+int csr_dijkstra(csr* c, size_t sp, size_t ep, varray* path)
+{
+    int* distance = (int*)csr_alloc_(c->nnodes, sizeof(int));
+    uint32_t* src = (uint32_t*)csr_alloc_(c->nnodes, sizeof(uint32_t));
+    va_iheap* h/*eap*/ = va_iheap_create(c->nnodes);
+
+    for(size_t i = 0; i < c->nnodes; i++) distance[i] = INT_MAX;
+    distance[sp] = 0;
+    src[sp] = sp;
+    va_iheap_push(h, sp, 0);
+
+    while(va_iheap_length(h)) {
+        size_t n = va_iheap_pop(h, NULL);
+        if(n == ep) break;
+
+        for(size_t i = c->offsets[n]; i < c->offsets[n + 1]; i++) {
+            int expect = distance[n] + c->weights[i];
+            uint32_t m = c->nbrs[i];
+            if(expect >= distance[m]) continue;
+            distance[m] = expect;
+            src[m] = n;
+            va_iheap_push(h, m, expect);
+        }
+    }
+
+    int result = distance[ep];
+    if(path && result != INT_MAX) {
+        size_t start = path->length;
+        for(size_t n = ep; ; n = src[n]) {
+            va_append(path, &n);
+            if(n == sp) break;
+        }
+        // reverse what's appended into the order from sp to ep
+        for(size_t i = start, j = path->length - 1; i < j; i++, j--)
+            va_swap(path, i, j);
+    }
+
+    va_iheap_destroy(h);
+    free(src);
+    free(distance);
+
+    return result;
+}
+
+long csr_mst(csr* c, varray* st)
+{
+    uint8_t* visited = (uint8_t*)calloc(c->nnodes ? c->nnodes : 1, 1);
+    if(!visited) toss(MemoryError);
+    varray* h/*eap*/ = va_create(csr_heap_entry);
+    long total = 0;
+
+    for(size_t root = 0; root < c->nnodes; root++) {
+        if(visited[root]) continue;
+
+        csr_heap_entry top = { 0, root, root };
+        va_heap_insert(h, csr_heap_cmp_, &top);
+
+        while(h->length) {
+            top = va_cast(csr_heap_entry, h)[0];
+            va_heap_remove(h, csr_heap_cmp_, 0);
+            if(visited[top.n]) continue;
+            visited[top.n] = 1;
+
+            if(top.n != root) {
+                total += top.distance;
+                csr_edge e = { top.src, top.n, top.distance };
+                if(st) va_append(st, &e);
+            }
+
+            for(size_t i = c->offsets[top.n]; i < c->offsets[top.n + 1]; i++) {
+                if(visited[c->nbrs[i]]) continue;
+                csr_heap_entry e = { c->weights[i], c->nbrs[i], top.n };
+                va_heap_insert(h, csr_heap_cmp_, &e);
+            }
+        }
+    }
+
+    va_destroy(h);
+    free(visited);
+
+    return total;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Parallel BFS
+
+// a frontier edges count over unvisited edges count above 1 / ALPHA turns to
+// bottom-up, and a frontier under nnodes / BETA turns back to top-down
+#define BFS_ALPHA 14
+#define BFS_BETA 24
+#define CHUNKS_PER_THREAD 8
+
+#define bit_test(bm, i) \
+    (__atomic_load_n((bm) + (i) / 64, __ATOMIC_RELAXED) >> ((i) % 64) & 1)
+#define bit_mask(i) ((uint64_t)1 << ((i) % 64))
+
+typedef struct csr_bfs_state_t_ {
+    csr* c;
+    int* hops;
+    int level;
+    uint64_t* visited;
+    uint64_t* frontier;
+    uint64_t* next;
+    size_t nwords;
+    size_t nchunks;
+    size_t* nf; // per chunk, nodes and out-edges in the next frontier
+    size_t* mf;
+} csr_bfs_state;
+
+#define chunk_begin(st, i) ((st)->nwords * (i) / (st)->nchunks)
+
+// claim m for the next frontier, return whether it was unvisited
+static int csr_bfs_claim_(csr_bfs_state* st, size_t chunk, uint32_t m)
+{
+    uint64_t old = __atomic_fetch_or(st->visited + m / 64, bit_mask(m),
+            __ATOMIC_RELAXED);
+    if(old & bit_mask(m)) return 0;
+
+    st->hops[m] = st->level + 1;
+    __atomic_fetch_or(st->next + m / 64, bit_mask(m), __ATOMIC_RELAXED);
+    st->nf[chunk]++;
+    st->mf[chunk] += csr_degree(st->c, m);
+    return 1;
+}
+
+static void csr_bfs_top_down_(size_t chunk, void* usr)
+{
+    csr_bfs_state* st = (csr_bfs_state*)usr;
+    csr* c = st->c;
+
+    for(size_t w = chunk_begin(st, chunk); w < chunk_begin(st, chunk + 1); w++)
+        for(uint64_t bits = st->frontier[w]; bits; bits &= bits - 1) {
+            size_t n = w * 64 + __builtin_ctzll(bits);
+            for(size_t i = c->offsets[n]; i < c->offsets[n + 1]; i++)
+                if(!bit_test(st->visited, c->nbrs[i]))
+                    csr_bfs_claim_(st, chunk, c->nbrs[i]);
+        }
+}
+
+static void csr_bfs_bottom_up_(size_t chunk, void* usr)
+{
+    csr_bfs_state* st = (csr_bfs_state*)usr;
+    csr* c = st->c;
+
+    for(size_t w = chunk_begin(st, chunk); w < chunk_begin(st, chunk + 1); w++)
+        for(size_t n = w * 64; n < w * 64 + 64 && n < c->nnodes; n++) {
+            if(bit_test(st->visited, n)) continue;
+            for(size_t i = c->in_offsets[n]; i < c->in_offsets[n + 1]; i++)
+                if(bit_test(st->frontier, c->in_nbrs[i])) {
+                    csr_bfs_claim_(st, chunk, n);
+                    break;
+                }
+        }
+}
+
+static void csr_bfs_release_(csr_bfs_state* st)
+{
+    free(st->mf);
+    free(st->nf);
+    free(st->next);
+    free(st->frontier);
+    free(st->visited);
+}
+
+void csr_bfs_parallel(csr* c, size_t sp, int* hops, size_t nthreads)
+{
+    csr_bfs_state st;
+    if(!nthreads) nthreads = tp_ncpus();
+
+    st.c = c;
+    st.hops = hops;
+    st.level = 0;
+    st.nwords = (c->nnodes + 63) / 64;
+    st.nchunks = nthreads * CHUNKS_PER_THREAD;
+    if(st.nchunks > st.nwords) st.nchunks = st.nwords;
+    st.visited = (uint64_t*)calloc(st.nwords + 1, sizeof(uint64_t));
+    st.frontier = (uint64_t*)calloc(st.nwords + 1, sizeof(uint64_t));
+    st.next = (uint64_t*)calloc(st.nwords + 1, sizeof(uint64_t));
+    st.nf = (size_t*)calloc(st.nchunks + 1, sizeof(size_t));
+    st.mf = (size_t*)calloc(st.nchunks + 1, sizeof(size_t));
+    if(!st.visited || !st.frontier || !st.next || !st.nf || !st.mf) {
+        csr_bfs_release_(&st);
+        toss(MemoryError);
+    }
+
+    // created last, so a failed allocation has no pool to tear down
+    thrpool* tp = tp_create(nthreads);
+
+    for(size_t i = 0; i < c->nnodes; i++) hops[i] = -1;
+    hops[sp] = 0;
+    st.visited[sp / 64] |= bit_mask(sp);
+    st.frontier[sp / 64] |= bit_mask(sp);
+
+    size_t nf = 1, mf = csr_degree(c, sp), mu = c->nadj - mf;
+    int bottom_up = 0;
+
+    while(nf) {
+        if(!bottom_up && mf > mu / BFS_ALPHA) bottom_up = 1;
+        else if(bottom_up && nf < c->nnodes / BFS_BETA) bottom_up = 0;
+
+        memset(st.nf, 0, st.nchunks * sizeof(size_t));
+        memset(st.mf, 0, st.nchunks * sizeof(size_t));
+        tp_parallel_for(tp, st.nchunks, bottom_up ?
+                csr_bfs_bottom_up_ : csr_bfs_top_down_, &st);
+
+        nf = mf = 0;
+        for(size_t i = 0; i < st.nchunks; i++) {
+            nf += st.nf[i];
+            mf += st.mf[i];
+        }
+        mu -= mf;
+
+        uint64_t* t = st.frontier;
+        st.frontier = st.next;
+        st.next = t;
+        memset(st.next, 0, st.nwords * sizeof(uint64_t));
+        st.level++;
+    }
+
+    csr_bfs_release_(&st);
+    tp_destroy(tp);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Parallel Connected Components
+
+typedef struct csr_cc_state_t_ {
+    csr* c;
+    uint32_t* labels;
+    size_t nchunks;
+    int changed;
+} csr_cc_state;
+
+#define cc_chunk_begin(st, i) ((st)->c->nnodes * (i) / (st)->nchunks)
+
+static uint32_t csr_cc_min_(uint32_t* labels, uint32_t* nbrs,
+        size_t begin, size_t end, uint32_t least)
+{
+    for(size_t i = begin; i < end; i++) {
+        uint32_t l = __atomic_load_n(labels + nbrs[i], __ATOMIC_RELAXED);
+        if(l < least) least = l;
+    }
+    return least;
+}
+
+static void csr_cc_propagate_(size_t chunk, void* usr)
+{
+    csr_cc_state* st = (csr_cc_state*)usr;
+    csr* c = st->c;
+    int changed = 0;
+
+    for(size_t n = cc_chunk_begin(st, chunk);
+            n < cc_chunk_begin(st, chunk + 1); n++) {
+        uint32_t label = __atomic_load_n(st->labels + n, __ATOMIC_RELAXED);
+        uint32_t least = csr_cc_min_(st->labels, c->nbrs,
+                c->offsets[n], c->offsets[n + 1], label);
+        if(c->gtype == DIRECTED)
+            least = csr_cc_min_(st->labels, c->in_nbrs,
+                    c->in_offsets[n], c->in_offsets[n + 1], least);
+
+        if(least < label) {
+            __atomic_store_n(st->labels + n, least, __ATOMIC_RELAXED);
+            changed = 1;
+        }
+    }
+
+    if(changed) __atomic_store_n(&st->changed, 1, __ATOMIC_RELAXED);
+}
+
+static void csr_cc_shortcut_(size_t chunk, void* usr)
+{
+    csr_cc_state* st = (csr_cc_state*)usr;
+    uint32_t* labels = st->labels;
+
+    for(size_t n = cc_chunk_begin(st, chunk);
+            n < cc_chunk_begin(st, chunk + 1); n++) {
+        uint32_t l = __atomic_load_n(labels + n, __ATOMIC_RELAXED), ll;
+        while((ll = __atomic_load_n(labels + l, __ATOMIC_RELAXED)) < l)
+            l = ll;
+        __atomic_store_n(labels + n, l, __ATOMIC_RELAXED);
+    }
+}
+
+size_t csr_components(csr* c, uint32_t* labels, size_t nthreads)
+{
+    thrpool* tp = tp_create(nthreads);
+    csr_cc_state st;
+
+    st.c = c;
+    st.labels = labels;
+    st.nchunks = tp->nworkers * CHUNKS_PER_THREAD;
+    if(st.nchunks > c->nnodes) st.nchunks = c->nnodes;
+
+    for(size_t i = 0; i < c->nnodes; i++) labels[i] = i;
+
+    do {
+        st.changed = 0;
+        tp_parallel_for(tp, st.nchunks, csr_cc_propagate_, &st);
+        tp_parallel_for(tp, st.nchunks, csr_cc_shortcut_, &st);
+    } while(st.changed);
+
+    tp_destroy(tp);
+
+    size_t ncomps = 0;
+    for(size_t i = 0; i < c->nnodes; i++)
+        if(labels[i] == i) ncomps++;
+    return ncomps;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Wrappers on graph
+
+void g_bfs_parallel(graph* g, gnode* sp, size_t nthreads,
+        void (*cb) (gnode*, int, void*), void* usr)
+{
+    csr* c = g_freeze(g);
+    int* hops = (int*)csr_alloc_(c->nnodes, sizeof(int));
+
+    csr_bfs_parallel(c, csr_index(sp), hops, nthreads);
+    for(size_t i = 0; i < c->nnodes; i++)
+        if(hops[i] >= 0) cb(c->nodes[i], hops[i], usr);
+
+    free(hops);
+    csr_destroy(c);
+}
+
+size_t g_components(graph* g, size_t nthreads,
+        void (*cb) (gnode*, size_t, void*), void* usr)
+{
+    csr* c = g_freeze(g);
+    uint32_t* labels = (uint32_t*)csr_alloc_(c->nnodes, sizeof(uint32_t));
+    size_t ncomps = csr_components(c, labels, nthreads);
+
+    // number components in order of their least indices, which always come
+    // first in the component
+    size_t* comp = (size_t*)csr_alloc_(c->nnodes, sizeof(size_t));
+    for(size_t i = 0, next = 0; i < c->nnodes; i++) {
+        comp[i] = labels[i] == i ? next++ : comp[labels[i]];
+        cb(c->nodes[i], comp[i], usr);
+    }
+
+    free(comp);
+    free(labels);
+    csr_destroy(c);
+
+    return ncomps;
+}
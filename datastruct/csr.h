@@ -0,0 +1,88 @@
+/*
+ * Copyright(c) 2015, Shihira Fung <fengzhiping@hotmail.com>
+ */
+
+#ifndef CSR_H_INCLUDED
+#define CSR_H_INCLUDED
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "graph.h"
+#include "varray.h"
+
+/*
+ * csr is an immutable snapshot of a graph in compressed sparse rows: nodes are
+ * numbered 0 to nnodes - 1, and the neighbors of node i, along with weights of
+ * the edges reaching them, are nbrs[offsets[i]] to nbrs[offsets[i+1] - 1].
+ * Visiting edges is thus a sequential scan over arrays instead of chasing
+ * lists of gedge pointers. Build and modify a graph, then freeze it for
+ * analysis, and freeze again after later changes.
+ *
+ * Neighbors are in the same order as in the adjacency lists, so algorithms
+ * here visit nodes in the same order as their counterparts on graph. An
+ * undirected edge is stored at both of its endpoints, and the incoming arrays
+ * of an undirected csr are the same as the outgoing ones.
+ */
+
+typedef struct csr_t_ {
+    graph_type gtype;
+    size_t nnodes;
+    size_t nadj; // length of nbrs
+    gnode** nodes; // nodes of the graph frozen, by index
+    size_t* offsets; // nnodes + 1 elements
+    uint32_t* nbrs;
+    int* weights;
+    size_t* in_offsets;
+    uint32_t* in_nbrs;
+    int* in_weights;
+} csr;
+
+typedef struct csr_edge_t_ {
+    uint32_t from;
+    uint32_t to;
+    int weight;
+} csr_edge;
+
+// g_freeze leaves in the rsrv of each node its index, which stays valid until
+// another algorithm on the graph overwrites rsrv
+csr* g_freeze(graph* g);
+void csr_destroy(csr* c);
+
+void csr_dfs(csr* c, size_t sp, void (*cb) (size_t, void*), void* usr);
+// hops[i] is the number of edges on the shortest path from sp to node i, or
+// -1 if node i is unreachable
+void csr_bfs(csr* c, size_t sp, int* hops);
+// returns INT_MAX if ep is unreachable, else fill path<size_t> if not null
+int csr_dijkstra(csr* c, size_t sp, size_t ep, varray* path);
+// Prim's algorithm from every tree not spanned yet, so the result is a minimum
+// spanning forest; fill st<csr_edge> if not null and return the total weight
+long csr_mst(csr* c, varray* st);
+
+/*
+ * Parallel algorithms on a pool of nthreads (0 for all processors). The BFS
+ * is direction-optimizing: while the frontier is small it expands the
+ * frontier through outgoing edges, claiming nodes in an atomic visited bitmap,
+ * and once the frontier has more edges than the unvisited part, every
+ * unvisited node looks for a parent in the frontier bitmap through incoming
+ * edges instead. hops is the same as that of csr_bfs.
+ *
+ * csr_components labels weakly connected components by propagating the least
+ * index through edges in parallel, shortcutting labels to labels of labels
+ * between rounds, until nothing changes. labels[i] is the least index in the
+ * component of node i, and the number of components is returned.
+ */
+void csr_bfs_parallel(csr* c, size_t sp, int* hops, size_t nthreads);
+size_t csr_components(csr* c, uint32_t* labels, size_t nthreads);
+
+// wrappers freezing the graph, which call back on every node reached, with
+// its hops from sp, or with its component numbered from 0 on
+void g_bfs_parallel(graph* g, gnode* sp, size_t nthreads,
+        void (*cb) (gnode*, int, void*), void* usr);
+size_t g_components(graph* g, size_t nthreads,
+        void (*cb) (gnode*, size_t, void*), void* usr);
+
+#define csr_index(n) ((size_t)(uintptr_t)(n)->rsrv)
+#define csr_degree(c, i) ((c)->offsets[(i) + 1] - (c)->offsets[i])
+
+#endif // CSR_H_INCLUDED
@@ -0,0 +1,100 @@
+/*
+ * Copyright(c) 2015, Shihira Fung <fengzhiping@hotmail.com>
+ */
+
+#include <stdlib.h>
+
+#include "dset.h"
+#include "exception.h"
+
+dset* dset_create(size_t n)
+{
+    dset* ds = (dset*)malloc(sizeof(dset));
+    if(!ds) toss(MemoryError);
+    ds->parent = (size_t*)malloc((n ? n : 1) * sizeof(size_t));
+    ds->rank = (uint8_t*)calloc(n ? n : 1, sizeof(uint8_t));
+    if(!ds->parent || !ds->rank) toss(MemoryError);
+
+    for(size_t i = 0; i < n; i++)
+        ds->parent[i] = i;
+    ds->length = ds->ncomps = n;
+
+    return ds;
+}
+
+void dset_destroy(dset* ds)
+{
+    free(ds->rank);
+    free(ds->parent);
+    free(ds);
+}
+
+size_t dset_find(dset* ds, size_t x)
+{
+    if(x >= ds->length) toss(OutOfRange);
+
+    size_t* parent = ds->parent;
+    while(parent[x] != x) {
+        // point x to its grandparent and go on from there
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+
+    return x;
+}
+
+int dset_union(dset* ds, size_t a, size_t b)
+{
+    a = dset_find(ds, a);
+    b = dset_find(ds, b);
+    if(a == b) return 0;
+
+    if(ds->rank[a] < ds->rank[b]) {
+        size_t t = a; a = b; b = t;
+    }
+    ds->parent[b] = a;
+    if(ds->rank[a] == ds->rank[b]) ds->rank[a]++;
+    ds->ncomps--;
+
+    return 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Concurrent Variants
+
+#define load_parent_(ds, x) __atomic_load_n((ds)->parent + (x), __ATOMIC_ACQUIRE)
+
+size_t dset_find_ts(dset* ds, size_t x)
+{
+    if(x >= ds->length) toss(OutOfRange);
+
+    for(size_t p; (p = load_parent_(ds, x)) != x; ) {
+        size_t gp = load_parent_(ds, p);
+        // another thread may have moved x meanwhile, then leave it alone
+        __atomic_compare_exchange_n(ds->parent + x, &p, gp, 0,
+                __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+        x = gp;
+    }
+
+    return x;
+}
+
+int dset_union_ts(dset* ds, size_t a, size_t b)
+{
+    while(1) {
+        a = dset_find_ts(ds, a);
+        b = dset_find_ts(ds, b);
+        if(a == b) return 0;
+
+        if(a > b) {
+            size_t t = a; a = b; b = t;
+        }
+        // b may have got a parent since found, then find again
+        size_t expected = b;
+        if(__atomic_compare_exchange_n(ds->parent + b, &expected, a, 0,
+                    __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            __atomic_fetch_sub(&ds->ncomps, 1, __ATOMIC_RELAXED);
+            return 1;
+        }
+    }
+}
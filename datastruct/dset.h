@@ -0,0 +1,42 @@
+/*
+ * Copyright(c) 2015, Shihira Fung <fengzhiping@hotmail.com>
+ */
+
+#ifndef DSET_H_INCLUDED
+#define DSET_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * dset is a disjoint set (union-find) of elements 0 to length-1 in flat
+ * arrays. dset_find halves paths as it climbs, and dset_union hangs the
+ * shallower tree under the deeper one, so a sequence of operations runs in
+ * nearly linear time.
+ *
+ * The _ts variants may run concurrently with one another, but not with the
+ * plain ones. They are lock-free: paths are halved by compare-and-swap, which
+ * is harmless when it fails, and a root is linked under another root only if
+ * it's still a root, with the smaller index always becoming the parent. Ranks
+ * aren't used by them.
+ */
+
+typedef struct dset_t_ {
+    size_t* parent;
+    uint8_t* rank;
+    size_t length;
+    size_t ncomps; // number of disjoint sets
+} dset;
+
+dset* dset_create(size_t n);
+void dset_destroy(dset* ds);
+size_t dset_find(dset* ds, size_t x);
+// returns whether a and b were in different sets
+int dset_union(dset* ds, size_t a, size_t b);
+
+size_t dset_find_ts(dset* ds, size_t x);
+int dset_union_ts(dset* ds, size_t a, size_t b);
+
+#define dset_same(ds, a, b) (dset_find(ds, a) == dset_find(ds, b))
+
+#endif // DSET_H_INCLUDED
@@ -0,0 +1,54 @@
+/*
+ * Copyright(c) 2015, Shihira Fung <fengzhiping@hotmail.com>
+ */
+
+#include "dsstat.h"
+#include "exception.h"
+
+uint64_t ds_stats_[DS_STAT_NCONTAINERS][DS_STAT_NCOUNTERS];
+
+static char const* container_names_[DS_STAT_NCONTAINERS] = {
+    "varray", "lnklist", "ulist", "bintree", "avltree",
+    "b_tree", "vaheap", "hashmap", "mempool",
+};
+
+static char const* counter_names_[DS_STAT_NCOUNTERS] = {
+    "allocs", "frees", "bytes", "reallocs", "compares",
+    "rotations", "splits", "merges", "sifts",
+};
+
+uint64_t ds_stat_get(ds_stat_container c, ds_stat_counter k)
+{
+    if(c >= DS_STAT_NCONTAINERS || k >= DS_STAT_NCOUNTERS)
+        toss(OutOfRange);
+    return __atomic_load_n(&ds_stats_[c][k], __ATOMIC_RELAXED);
+}
+
+void ds_stat_reset()
+{
+    for(int c = 0; c < DS_STAT_NCONTAINERS; c++)
+        for(int k = 0; k < DS_STAT_NCOUNTERS; k++)
+            __atomic_store_n(&ds_stats_[c][k], 0, __ATOMIC_RELAXED);
+}
+
+char const* ds_stat_container_name(ds_stat_container c)
+{
+    if(c >= DS_STAT_NCONTAINERS) toss(OutOfRange);
+    return container_names_[c];
+}
+
+char const* ds_stat_counter_name(ds_stat_counter k)
+{
+    if(k >= DS_STAT_NCOUNTERS) toss(OutOfRange);
+    return counter_names_[k];
+}
+
+void ds_stat_dump(FILE* f)
+{
+    for(int c = 0; c < DS_STAT_NCONTAINERS; c++)
+        for(int k = 0; k < DS_STAT_NCOUNTERS; k++) {
+            uint64_t v = ds_stat_get(c, k);
+            if(v) fprintf(f, "%s %s %lu\n", container_names_[c],
+                    counter_names_[k], (unsigned long)v);
+        }
+}
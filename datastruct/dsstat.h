@@ -0,0 +1,76 @@
+/*
+ * Copyright(c) 2015, Shihira Fung <fengzhiping@hotmail.com>
+ */
+
+#ifndef DSSTAT_H_INCLUDED
+#define DSSTAT_H_INCLUDED
+
+#include <stdio.h>
+#include <stdint.h>
+
+/*
+ * Operation counters of the instrumentation build. Compiling the library with
+ * -DDS_STATS makes every container type count its allocations, comparator
+ * calls and restructuring steps; otherwise the counting macros expand to
+ * nothing and all counters stay zero. Counters are kept per container type,
+ * not per instance, and are added atomically, so they can be read while
+ * thread pools are at work.
+ *
+ * Nodes of avltree are counted as bintree allocations, and blocks carved
+ * from slabs as mempool ones, so allocations of a container stand for calls
+ * to its own allocator, which isn't necessarily malloc.
+ */
+
+typedef enum ds_stat_container_e_ {
+    DS_STAT_VARRAY,
+    DS_STAT_LNKLIST,
+    DS_STAT_ULIST,
+    DS_STAT_BINTREE,
+    DS_STAT_AVLTREE,
+    DS_STAT_B_TREE,
+    DS_STAT_VAHEAP,
+    DS_STAT_HASHMAP,
+    DS_STAT_MEMPOOL,
+    DS_STAT_NCONTAINERS
+} ds_stat_container;
+
+typedef enum ds_stat_counter_e_ {
+    DS_STAT_ALLOCS,
+    DS_STAT_FREES,
+    DS_STAT_BYTES, // allocated in total, including reallocations
+    DS_STAT_REALLOCS,
+    DS_STAT_COMPARES,
+    DS_STAT_ROTATIONS, // avltree
+    DS_STAT_SPLITS, // b_tree
+    DS_STAT_MERGES, // b_tree
+    DS_STAT_SIFTS, // elements moved by a step of sifting up or down
+    DS_STAT_NCOUNTERS
+} ds_stat_counter;
+
+extern uint64_t ds_stats_[DS_STAT_NCONTAINERS][DS_STAT_NCOUNTERS];
+
+uint64_t ds_stat_get(ds_stat_container c, ds_stat_counter k);
+void ds_stat_reset();
+char const* ds_stat_container_name(ds_stat_container c);
+char const* ds_stat_counter_name(ds_stat_counter k);
+// print non-zero counters as lines of `<container> <counter> <value>`
+void ds_stat_dump(FILE* f);
+
+#ifdef DS_STATS
+#define ds_stat_add(c, k, n) ((void)__atomic_fetch_add( \
+            &ds_stats_[c][k], (uint64_t)(n), __ATOMIC_RELAXED))
+#else
+#define ds_stat_add(c, k, n) ((void)0)
+#endif
+
+#define ds_stat_inc(c, k) ds_stat_add(c, k, 1)
+#define ds_stat_alloc(c, bytes) (ds_stat_inc(c, DS_STAT_ALLOCS), \
+        ds_stat_add(c, DS_STAT_BYTES, bytes))
+#define ds_stat_realloc(c, bytes) (ds_stat_inc(c, DS_STAT_REALLOCS), \
+        ds_stat_add(c, DS_STAT_BYTES, bytes))
+#define ds_stat_free(c) ds_stat_inc(c, DS_STAT_FREES)
+// call a comparator, counting the call
+#define ds_stat_cmp(c, cmp, a, b) \
+    (ds_stat_inc(c, DS_STAT_COMPARES), (cmp)(a, b))
+
+#endif // DSSTAT_H_INCLUDED
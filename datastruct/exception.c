@@ -4,9 +4,22 @@
 
 #include "exception.h"
 
-jmp_buf jmp_context_stack_[64];
-size_t jmp_context_stack_len_;
-struct _except_status_t except_status;
+__thread jmp_buf jmp_context_stack_[EXCEPT_STACK_DEPTH];
+__thread size_t jmp_context_stack_len_;
+__thread struct _except_status_t except_status;
+
+jmp_buf* except_push_() {
+    if(jmp_context_stack_len_ == EXCEPT_STACK_DEPTH) {
+        fprintf(stderr, "Exception handlers overflow: more than %d nested\n",
+                EXCEPT_STACK_DEPTH);
+        abort();
+    }
+    return jmp_context_stack_ + jmp_context_stack_len_++;
+}
+
+void except_pop_() {
+    jmp_context_stack_len_--;
+}
 
 void toss_(const char* tag) {
     except_status.detail = NULL;
@@ -22,3 +35,10 @@ void next_handler_or_abort_() {
         abort();
     }
 }
+
+const char* ds_error_tag(ds_error err) {
+    static const char* tags[] = {
+        "OK", "OutOfRange", "Underflow", "KeyNotFound",
+    };
+    return tags[err];
+}
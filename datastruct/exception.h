@@ -19,25 +19,49 @@
  * - toss_else -> no corresponding keywords
  * - toss -> throw
  *
+ * Every thread has its own stack of handlers, at most EXCEPT_STACK_DEPTH
+ * examine blocks deep, beyond which the program aborts. A handler is popped
+ * when its block completes or something is tossed, so don't leave an examine
+ * block by return, break or goto.
  */
 
-#define examine if(setjmp(jmp_context_stack_[jmp_context_stack_len_++]) == 0)
+#define EXCEPT_STACK_DEPTH 64
+
+#define examine if(setjmp(*except_push_()) == 0) \
+    for(int examining_ = 1; examining_; examining_ = 0, except_pop_())
 #define grab(except_tag) else if(!strcmp(except_status.desc, #except_tag))
 #define grab_else else
 #define toss_else else next_handler_or_abort_();
 #define toss(tag) toss_(#tag)
 
-extern jmp_buf jmp_context_stack_[64];
-extern size_t jmp_context_stack_len_;
+extern __thread jmp_buf jmp_context_stack_[EXCEPT_STACK_DEPTH];
+extern __thread size_t jmp_context_stack_len_;
 
 struct _except_status_t {
     const char* desc;
     void* detail;
 };
 
-extern struct _except_status_t except_status;
+extern __thread struct _except_status_t except_status;
 
+jmp_buf* except_push_();
+void except_pop_();
 void toss_(const char* tag);
 void next_handler_or_abort_();
 
+/*
+ * Error codes returned by the try-functions (va_try_at, b_try_get, ...), which
+ * report the errors most likely on hot paths without tossing, and thus need
+ * no examine block. Other errors, such as running out of memory, are still
+ * tossed. ds_error_tag gives the tag the error would be tossed with.
+ */
+typedef enum ds_error_e_ {
+    DS_OK = 0,
+    DS_OUT_OF_RANGE,
+    DS_UNDERFLOW,
+    DS_KEY_NOT_FOUND,
+} ds_error;
+
+const char* ds_error_tag(ds_error err);
+
 #endif // EXCEPTION_H_INCLUDED
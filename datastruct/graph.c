@@ -10,6 +10,8 @@
 #include "varray.h"
 #include "vaheap.h"
 #include "exception.h"
+#include "dset.h"
+#include "thrpool.h"
 #include "graph.h"
 
 // You should read these macro name in this way:
@@ -29,8 +31,9 @@ graph* g_create_(size_t szelem, graph_type gt)
     graph* g = (graph*)malloc(sizeof(graph));
     if(!g) toss(MemoryFault);
     g->elem_size = szelem;
-    g->nodes = ll_create(gnode);
-    g->edges = ll_create(gedge);
+    g->nodes = ll_create_pooled(gnode, NULL);
+    g->edges = ll_create_pooled(gedge, NULL);
+    g->adj_pool = ll_pool_create(gedge*);
     g->gtype = gt;
 
     return g;
@@ -45,10 +48,10 @@ gnode* g_add_node(graph* g, void* data)
     if(data) memcpy(n.data, data, g->elem_size);
 
     if(g->gtype == DIRECTED) {
-        n.adj.directed.in = ll_create(gedge*);
-        n.adj.directed.out = ll_create(gedge*);
+        n.adj.directed.in = ll_create_pooled(gedge*, g->adj_pool);
+        n.adj.directed.out = ll_create_pooled(gedge*, g->adj_pool);
     } else if(g->gtype == UNDIRECTED) {
-        n.adj.undirected.bi = ll_create(gedge*);
+        n.adj.undirected.bi = ll_create_pooled(gedge*, g->adj_pool);
     }
 
     ll_prepend(g->nodes, &n);
@@ -92,10 +95,11 @@ void g_disconnect(graph* g, gedge* e)
 
 void g_rm_node(graph* g, gnode* n)
 {
-    for(ll_iter i = edges_in(g, n)->head; !ll_is_end(i); i = i->next)
-        g_disconnect(g, casti_edgep(i));
-    for(ll_iter i = edges_out(g, n)->head; !ll_is_end(i); i = i->next)
-        g_disconnect(g, casti_edgep(i));
+    // disconnecting removes the iterator, so always take the first one
+    while(!ll_is_end(edges_in(g, n)->head))
+        g_disconnect(g, casti_edgep(edges_in(g, n)->head));
+    while(!ll_is_end(edges_out(g, n)->head))
+        g_disconnect(g, casti_edgep(edges_out(g, n)->head));
 
     if(n->data) free(n->data);
     if(g->gtype == UNDIRECTED)
@@ -124,6 +128,7 @@ void g_destroy(graph* g)
 
     ll_destroy(g->nodes);
     ll_destroy(g->edges);
+    mp_destroy(g->adj_pool);
     free(g);
 }
 
@@ -158,88 +163,150 @@ void g_dfs(graph* g, gnode* sp, void (*cb) (gnode*, void*), void* usr)
 ////////////////////////////////////////////////////////////////////////////////
 // Dijkstra's Algorithm
 
-#define castp_dijkp(p) (*(dijk_info**)(p))
-#define castp_dijk(p) ((dijk_info*)(p))
-
 typedef struct dijk_info_t_ {
     gnode* n;
-    gnode* src;
-    size_t hpos; // position in the heap, for the convenience of updating
+    size_t src; // index of the previous node on the path, self for sp
     int distance;
 } dijk_info;
 
-static int dijkp_cmp_(void* l, void* r)
+#define indexof(n) ((size_t)(uintptr_t)(n)->rsrv)
+
+// number nodes in rsrv for a flat array of dijk_info
+static dijk_info* dijk_init_(graph* g)
 {
-    // minimum heap comparator
-    return castp_dijkp(r)->distance - castp_dijkp(l)->distance;
+    dijk_info* info = (dijk_info*)malloc(
+            (g->nodes->length ? g->nodes->length : 1) * sizeof(dijk_info));
+    if(!info) toss(MemoryError);
+
+    size_t idx = 0;
+    for(ll_iter i = g->nodes->head; !ll_is_end(i); i = i->next, idx++) {
+        gnode* n = casti_node(i);
+        n->rsrv = (void*)(uintptr_t)idx;
+        info[idx].n = n;
+        info[idx].src = idx;
+        info[idx].distance = INT_MAX;
+    }
+
+    return info;
 }
 
-static void dijkp_swp_(varray* va, size_t a, size_t b)
+// relax edges of n in the list, return the index of a node also reached by
+// the other search in `other`, through which the path is shorter than *best
+static size_t dijk_relax_(lnklist* edges, gnode* n, dijk_info* info,
+        va_iheap* h, g_heuristic heur, gnode* ep, void* usr,
+        dijk_info* other, int* best)
 {
-    castp_dijkp(va_at(va, a))->hpos = b;
-    castp_dijkp(va_at(va, b))->hpos = a;
-    va_swap(va, a, b);
+    size_t ni = indexof(n), meet = SIZE_MAX;
+
+    for(ll_iter i = edges->head; !ll_is_end(i); i = i->next) {
+        gedge* scanned_e = casti_edgep(i);
+        gnode* scanned_n = g_endpoint(scanned_e, n);
+        size_t si = indexof(scanned_n);
+
+        int expect = info[ni].distance + scanned_e->weight;
+        if(info[si].distance <= expect) continue;
+
+        info[si].distance = expect;
+        info[si].src = ni;
+        va_iheap_push(h, si, heur ?
+                (int64_t)expect + heur(scanned_n, ep, usr) : expect);
+
+        if(other && other[si].distance != INT_MAX &&
+                (int64_t)expect + other[si].distance < *best) {
+            *best = expect + other[si].distance;
+            meet = si;
+        }
+    }
+
+    return meet;
 }
 
 int g_dijkstra(graph* g, gnode* sp, gnode* ep, lnklist/*<gnode*>*/* path)
 {
-    lnklist* info_buf = ll_create(dijk_info);
-    varray* h/*eap*/ = va_create(dijk_info*);
+    return g_astar(g, sp, ep, path, NULL, NULL);
+}
 
-    for(ll_iter i = g->nodes->head; !ll_is_end(i); i = i->next) {
-        gnode* n = casti_node(i);
+int g_astar(graph* g, gnode* sp, gnode* ep, lnklist/*<gnode*>*/* path,
+        g_heuristic heur, void* usr)
+{
+    // push only nodes reached, and stop once ep is settled
+    dijk_info* info = dijk_init_(g);
+    va_iheap* h/*eap*/ = va_iheap_create(g->nodes->length);
 
-        dijk_info info;
-        info.n = n;
-        info.src = NULL;
-        info.distance = n == sp ? 0 : INT_MAX;
-        ll_prepend(info_buf, &info);
+    info[indexof(sp)].distance = 0;
+    va_iheap_push(h, indexof(sp), 0);
 
-        n->rsrv = ll_at(info_buf, 0);
-        va_heap_insert(h, dijkp_cmp_, &(n->rsrv));
+    while(va_iheap_length(h)) {
+        gnode* n = info[va_iheap_pop(h, NULL)].n;
+        if(n == ep) break;
+        dijk_relax_(edges_out(g, n), n, info, h,
+                heur, ep, usr, NULL, NULL);
     }
 
-    for(size_t i = 0; i < h->length; i++)
-        castp_dijkp(va_at(h, i))->hpos = i;
+    int distance = info[indexof(ep)].distance;
+    // retreive the path from `dijk_info`s
+    if(path && distance != INT_MAX) {
+        for(size_t i = indexof(ep); ; i = info[i].src) {
+            ll_prepend(path, &info[i].n);
+            if(info[i].src == i) break;
+        }
+    }
 
-    while(h->length) {
-        dijk_info* info = castp_dijkp(va_at(h, 0));
-        gnode* n = info->n;
-        va_heap_remove_generic(h, dijkp_cmp_, dijkp_swp_, 0);
+    va_iheap_destroy(h);
+    free(info);
 
-        if(n == ep) break;
+    return distance;
+}
 
-        for(ll_iter i = edges_out(g, n)->head; !ll_is_end(i); i = i->next) {
-            gedge* scanned_e = casti_edgep(i);
-            gnode* scanned_n = g_endpoint(scanned_e, n);
-            dijk_info* scanned_info = castp_dijk(scanned_n->rsrv);
-
-            int expect = info->distance + scanned_e->weight;
-            if(scanned_info->distance > expect) {
-                va_heap_remove_generic(h, dijkp_cmp_,
-                        dijkp_swp_, scanned_info->hpos);
-                scanned_info->distance = expect;
-                scanned_info->src = n;
-                va_heap_insert_generic(h, dijkp_cmp_,
-                        dijkp_swp_, &scanned_info);
-            }
-        }
+int g_bidijkstra(graph* g, gnode* sp, gnode* ep, lnklist/*<gnode*>*/* path)
+{
+    dijk_info* fwd = dijk_init_(g);
+    dijk_info* bwd = (dijk_info*)malloc(
+            (g->nodes->length ? g->nodes->length : 1) * sizeof(dijk_info));
+    if(!bwd) toss(MemoryError);
+    memcpy(bwd, fwd, g->nodes->length * sizeof(dijk_info));
+    va_iheap* hf = va_iheap_create(g->nodes->length);
+    va_iheap* hb = va_iheap_create(g->nodes->length);
+
+    size_t meet = indexof(sp);
+    int best = sp == ep ? 0 : INT_MAX;
+    fwd[indexof(sp)].distance = bwd[indexof(ep)].distance = 0;
+    va_iheap_push(hf, indexof(sp), 0);
+    va_iheap_push(hb, indexof(ep), 0);
+
+    // grow the side with the nearer top, until no path through unsettled
+    // nodes can be shorter than the best one found
+    while(va_iheap_length(hf) && va_iheap_length(hb) &&
+            va_iheap_top(hf).key + va_iheap_top(hb).key < best) {
+        int forward = va_iheap_top(hf).key <= va_iheap_top(hb).key;
+        gnode* n = forward ? fwd[va_iheap_pop(hf, NULL)].n :
+            bwd[va_iheap_pop(hb, NULL)].n;
+
+        size_t m = forward ?
+            dijk_relax_(edges_out(g, n), n, fwd, hf,
+                    NULL, NULL, NULL, bwd, &best) :
+            dijk_relax_(edges_in(g, n), n, bwd, hb,
+                    NULL, NULL, NULL, fwd, &best);
+        if(m != SIZE_MAX) meet = m;
     }
 
-    int distance = castp_dijk(ep->rsrv)->distance;
-    // retreive the path from `dijk_info`s
-    if(path) {
-        gnode* src = ep;
-        while(src) {
-            ll_prepend(path, &src);
-            src = castp_dijk(src->rsrv)->src;
+    if(path && best != INT_MAX) {
+        for(size_t i = meet; ; i = fwd[i].src) {
+            ll_prepend(path, &fwd[i].n);
+            if(fwd[i].src == i) break;
+        }
+        for(size_t i = meet; bwd[i].src != i; ) {
+            i = bwd[i].src;
+            ll_append(path, &bwd[i].n);
         }
     }
 
-    ll_destroy(info_buf);
-    va_destroy(h);
+    va_iheap_destroy(hb);
+    va_iheap_destroy(hf);
+    free(bwd);
+    free(fwd);
 
-    return distance;
+    return best;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -274,13 +341,6 @@ void g_dump(graph* g, varray* buf, void (*quote) (varray*, gnode*))
 ////////////////////////////////////////////////////////////////////////////////
 // Kruskal's Algorithm
 
-#define castp_krus(p) ((krus_info*)(p))
-
-typedef struct krus_info_t {
-    gnode/*<gnode*>*/* st_n;
-    gnode* ufs_n; // position in union-find set
-} krus_info;
-
 static int edge_cmp_(void* l, void* r)
 {
     return (*(gedge**)l)->weight - (*(gedge**)r)->weight;
@@ -289,46 +349,146 @@ static int edge_cmp_(void* l, void* r)
 void g_kruskal(graph* g, graph/*<gnode*>*/* st)
 {
     varray* edges = va_create(gedge*);
-    lnklist* info_buf = ll_create(krus_info);
-    graph* ufs = ufs_create(gnode*);
+    // nodes of the spanning tree, in the order numbered in rsrv
+    gnode** st_nodes = (gnode**)malloc(
+            (g->nodes->length ? g->nodes->length : 1) * sizeof(gnode*));
+    if(!st_nodes) toss(MemoryError);
+    dset* ds = dset_create(g->nodes->length);
 
     for(ll_iter i = g->edges->head; !ll_is_end(i); i = i->next) {
         gedge* e = casti_edge(i);
         va_append(edges, &e);
     }
 
-    for(ll_iter i = g->nodes->head; !ll_is_end(i); i = i->next) {
+    size_t idx = 0;
+    for(ll_iter i = g->nodes->head; !ll_is_end(i); i = i->next, idx++) {
         gnode* n = casti_node(i);
-        gnode* st_n = g_add_node(st, &n);
-
-        krus_info info;
-        info.st_n = st_n;
-        info.ufs_n = ufs_add_comp(ufs, &n);
-
-        ll_prepend(info_buf, &info);
-        n->rsrv = ll_at(info_buf, 0);
+        st_nodes[idx] = g_add_node(st, &n);
+        n->rsrv = (void*)(uintptr_t)idx;
     }
 
     // sort in increasing order
     va_sort(edges, edge_cmp_);
 
-    for(size_t i = 0; i < edges->length; i++) {
+    for(size_t i = 0; i < edges->length && ds->ncomps > 1; i++) {
         gedge* e = *(gedge**)va_at(edges, i);
-        krus_info* hinfo = castp_krus(e->head->rsrv);
-        krus_info* tinfo = castp_krus(e->tail->rsrv);
+        size_t h = indexof(e->head), t = indexof(e->tail);
 
-        if(ufs_find(ufs, hinfo->ufs_n) != ufs_find(ufs, tinfo->ufs_n)) {
-            // NOTE: optimize with mfset
-            ufs_union(ufs, hinfo->ufs_n, tinfo->ufs_n);
-            g_connect(st, hinfo->st_n, tinfo->st_n, e->weight);
-        }
+        if(dset_union(ds, h, t))
+            g_connect(st, st_nodes[h], st_nodes[t], e->weight);
     }
 
-    g_destroy(ufs);
-    ll_destroy(info_buf);
+    dset_destroy(ds);
+    free(st_nodes);
     va_destroy(edges);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Boruvka's Algorithm
+
+#define BORUVKA_NONE SIZE_MAX
+#define BORUVKA_CHUNKS_PER_THREAD 8
+
+typedef struct boruvka_info_t_ {
+    dset* ds;
+    size_t nedges;
+    size_t* heads; // endpoints and weights of edges by index
+    size_t* tails;
+    int* weights;
+    size_t* cheapest; // by root of components, an edge index
+    size_t nchunks;
+} boruvka_info;
+
+// equal weights are ordered by index, so that cheapest edges never form cycles
+#define boruvka_lighter_(info, a, b) ((info)->weights[a] < (info)->weights[b] || \
+        ((info)->weights[a] == (info)->weights[b] && (a) < (b)))
+
+static void boruvka_offer_(boruvka_info* info, size_t root, size_t e)
+{
+    size_t cur = __atomic_load_n(info->cheapest + root, __ATOMIC_RELAXED);
+    while(cur == BORUVKA_NONE || boruvka_lighter_(info, e, cur))
+        if(__atomic_compare_exchange_n(info->cheapest + root, &cur, e, 0,
+                    __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            break;
+}
+
+static void boruvka_scan_(size_t chunk, void* usr)
+{
+    boruvka_info* info = (boruvka_info*)usr;
+    size_t begin = info->nedges * chunk / info->nchunks,
+           end = info->nedges * (chunk + 1) / info->nchunks;
+
+    for(size_t e = begin; e < end; e++) {
+        size_t h = dset_find_ts(info->ds, info->heads[e]),
+               t = dset_find_ts(info->ds, info->tails[e]);
+        if(h == t) continue;
+        boruvka_offer_(info, h, e);
+        boruvka_offer_(info, t, e);
+    }
+}
+
+void g_boruvka(graph* g, graph/*<gnode*>*/* st, size_t nthreads)
+{
+    size_t nnodes = g->nodes->length, nedges = g->edges->length;
+    gnode** st_nodes = (gnode**)malloc((nnodes ? nnodes : 1) * sizeof(gnode*));
+    boruvka_info info;
+
+    info.ds = dset_create(nnodes);
+    info.nedges = nedges;
+    info.heads = (size_t*)malloc((nedges ? nedges : 1) * sizeof(size_t));
+    info.tails = (size_t*)malloc((nedges ? nedges : 1) * sizeof(size_t));
+    info.weights = (int*)malloc((nedges ? nedges : 1) * sizeof(int));
+    info.cheapest = (size_t*)malloc((nnodes ? nnodes : 1) * sizeof(size_t));
+    if(!st_nodes || !info.heads || !info.tails ||
+            !info.weights || !info.cheapest)
+        toss(MemoryError);
+
+    size_t idx = 0;
+    for(ll_iter i = g->nodes->head; !ll_is_end(i); i = i->next, idx++) {
+        gnode* n = casti_node(i);
+        st_nodes[idx] = g_add_node(st, &n);
+        n->rsrv = (void*)(uintptr_t)idx;
+        info.cheapest[idx] = BORUVKA_NONE;
+    }
+
+    idx = 0;
+    for(ll_iter i = g->edges->head; !ll_is_end(i); i = i->next, idx++) {
+        info.heads[idx] = indexof(casti_edge(i)->head);
+        info.tails[idx] = indexof(casti_edge(i)->tail);
+        info.weights[idx] = casti_edge(i)->weight;
+    }
+
+    thrpool* tp = tp_create(nthreads);
+    info.nchunks = tp->nworkers * BORUVKA_CHUNKS_PER_THREAD;
+
+    // every round at least halves the components that have outgoing edges
+    for(int merged = 1; merged && info.ds->ncomps > 1; ) {
+        tp_parallel_for(tp, info.nchunks, boruvka_scan_, &info);
+
+        merged = 0;
+        for(size_t r = 0; r < nnodes; r++) {
+            size_t e = info.cheapest[r];
+            if(e == BORUVKA_NONE) continue;
+            info.cheapest[r] = BORUVKA_NONE;
+
+            // the two components may both have chosen e
+            if(dset_union(info.ds, info.heads[e], info.tails[e])) {
+                g_connect(st, st_nodes[info.heads[e]],
+                        st_nodes[info.tails[e]], info.weights[e]);
+                merged = 1;
+            }
+        }
+    }
+
+    tp_destroy(tp);
+    free(info.cheapest);
+    free(info.weights);
+    free(info.tails);
+    free(info.heads);
+    dset_destroy(info.ds);
+    free(st_nodes);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Prim's Algorit
 
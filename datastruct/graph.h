@@ -58,6 +58,7 @@ typedef struct graph_t_ {
     lnklist/*<gedge>*/* edges;
     size_t elem_size;
     graph_type gtype;
+    mempool* adj_pool; // shared by adjacency lists of all nodes
 } graph;
 
 #define g_create(type, gt) g_create_(sizeof(type), gt)
@@ -74,8 +75,22 @@ void g_destroy(graph* g);
 
 void g_dfs(graph* g, gnode* sp, void (*cb) (gnode*, void*), void* usr);
 int g_dijkstra(graph* g, gnode* sp, gnode* ep, lnklist/*<gnode*>*/* path);
+/*
+ * Point-to-point variants of g_dijkstra, returning the distance and path in
+ * the same way. g_astar settles nodes in order of distance plus the estimate
+ * by heur of the distance left to ep, which must never overestimate it, or
+ * the path found may not be the shortest. g_bidijkstra searches from sp along
+ * edges and from ep against edges at the same time, until they meet.
+ */
+typedef int (*g_heuristic) (gnode* n, gnode* ep, void* usr);
+int g_astar(graph* g, gnode* sp, gnode* ep, lnklist/*<gnode*>*/* path,
+        g_heuristic heur, void* usr);
+int g_bidijkstra(graph* g, gnode* sp, gnode* ep, lnklist/*<gnode*>*/* path);
 void g_kruskal(graph* g, graph* st);
 void g_prim(graph* g, graph* st);
+// rounds of picking the lightest edge out of every component, found over
+// edges split across nthreads (0 for all processors), then merged
+void g_boruvka(graph* g, graph* st, size_t nthreads);
 
 // requires manual free
 void g_dump(graph* g, varray* buf, void (*quote) (varray*, gnode*));
@@ -0,0 +1,319 @@
+/*
+ * Copyright(c) 2015, Shihira Fung <fengzhiping@hotmail.com>
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "dsstat.h"
+#include "hashmap.h"
+
+#define CTRL_EMPTY ((int8_t)-128)
+#define CTRL_DELETED ((int8_t)-2)
+#define NOT_FOUND ((size_t)-1)
+
+#define h1_(h) ((h) >> 7)
+#define h2_(h) ((int8_t)((h) & 0x7f))
+
+////////////////////////////////////////////////////////////////////////////////
+// Control Groups
+
+// bit i of the results stands for ctrl[i], i < HM_GROUP
+#ifdef __SSE2__
+static inline uint32_t match_(int8_t const* ctrl, int8_t c)
+{
+    __m128i g = _mm_loadu_si128((__m128i const*)ctrl);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8(c)));
+}
+
+// EMPTY and DELETED are the only negative control bytes
+static inline uint32_t match_free_(int8_t const* ctrl)
+{
+    __m128i g = _mm_loadu_si128((__m128i const*)ctrl);
+    return (uint32_t)_mm_movemask_epi8(g);
+}
+#else
+static inline uint32_t match_(int8_t const* ctrl, int8_t c)
+{
+    uint32_t m = 0;
+    for(int i = 0; i < HM_GROUP; i++)
+        m |= (uint32_t)(ctrl[i] == c) << i;
+    return m;
+}
+
+static inline uint32_t match_free_(int8_t const* ctrl)
+{
+    uint32_t m = 0;
+    for(int i = 0; i < HM_GROUP; i++)
+        m |= (uint32_t)(ctrl[i] < 0) << i;
+    return m;
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Tables
+
+// the largest power of 2 dividing sz, up to 8
+static size_t align_of_(size_t sz)
+{
+    size_t a = sz & -sz;
+    return a == 0 || a > 8 ? 8 : a;
+}
+
+#define round_up_(sz, a) (((sz) + (a) - 1) & ~((a) - 1))
+#define slot_at(hm, t, i) ((t)->slots + (i) * (hm)->slot_size)
+
+// at most 7/8 of the slots are used, so probing always meets an empty one
+static void table_init_(hashmap* hm, hm_table* t, size_t capacity)
+{
+    t->ctrl = (int8_t*)malloc(capacity + HM_GROUP);
+    t->slots = (uint8_t*)malloc(capacity * hm->slot_size);
+    if(!t->ctrl || !t->slots) toss(MemoryError);
+    ds_stat_alloc(DS_STAT_HASHMAP, capacity + HM_GROUP);
+    ds_stat_alloc(DS_STAT_HASHMAP, capacity * hm->slot_size);
+
+    memset(t->ctrl, CTRL_EMPTY, capacity + HM_GROUP);
+    t->capacity = capacity;
+    t->length = 0;
+    t->growth_left = capacity - capacity / 8;
+}
+
+static void table_free_(hm_table* t)
+{
+    if(t->ctrl) ds_stat_add(DS_STAT_HASHMAP, DS_STAT_FREES, 2);
+    free(t->ctrl);
+    free(t->slots);
+    memset(t, 0, sizeof(hm_table));
+}
+
+// the first group is mirrored behind the last slot, so that a group can be
+// loaded from any position without wrapping around
+static inline void set_ctrl_(hm_table* t, size_t i, int8_t c)
+{
+    t->ctrl[i] = c;
+    if(i < HM_GROUP) t->ctrl[t->capacity + i] = c;
+}
+
+/*
+ * Probe group by group, at triangular offsets. With a power of 2 of groups,
+ * the sequence reaches every one of them before repeating.
+ */
+static size_t table_find_(hashmap* hm, hm_table* t, void const* key, uint64_t h)
+{
+    size_t mask = t->capacity - 1;
+    size_t pos = h1_(h) & mask;
+    int8_t tag = h2_(h);
+
+    for(size_t step = HM_GROUP; ; step += HM_GROUP) {
+        int8_t const* g = t->ctrl + pos;
+        for(uint32_t m = match_(g, tag); m; m &= m - 1) {
+            size_t i = (pos + __builtin_ctz(m)) & mask;
+            if(!ds_stat_cmp(DS_STAT_HASHMAP, hm->cmp, key, slot_at(hm, t, i)))
+                return i;
+        }
+        if(match_(g, CTRL_EMPTY)) return NOT_FOUND;
+        pos = (pos + step) & mask;
+    }
+}
+
+// claim the first free slot on the probe sequence of h
+static size_t table_claim_(hm_table* t, uint64_t h)
+{
+    size_t mask = t->capacity - 1;
+    size_t pos = h1_(h) & mask;
+
+    for(size_t step = HM_GROUP; ; step += HM_GROUP) {
+        uint32_t m = match_free_(t->ctrl + pos);
+        if(m) {
+            size_t i = (pos + __builtin_ctz(m)) & mask;
+            if(t->ctrl[i] == CTRL_EMPTY) t->growth_left--;
+            set_ctrl_(t, i, h2_(h));
+            t->length++;
+            return i;
+        }
+        pos = (pos + step) & mask;
+    }
+}
+
+static void table_erase_(hm_table* t, size_t i)
+{
+    set_ctrl_(t, i, CTRL_DELETED);
+    t->length--;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Incremental Resizing
+
+// move up to n slots of the old table into the current one
+static void migrate_(hashmap* hm, size_t n)
+{
+    hm_table* old = &hm->old;
+    if(!old->capacity) return;
+
+    size_t end = old->capacity - hm->migrated < n ?
+        old->capacity : hm->migrated + n;
+
+    for(size_t i = hm->migrated; i < end; i++) {
+        if(old->ctrl[i] < 0) continue;
+        uint8_t* s = slot_at(hm, old, i);
+        size_t j = table_claim_(&hm->cur, hm->hash(s));
+        memcpy(slot_at(hm, &hm->cur, j), s, hm->slot_size);
+        // not EMPTY, which would cut probe sequences passing by
+        table_erase_(old, i);
+    }
+
+    hm->migrated = end;
+    if(end == old->capacity) table_free_(old);
+}
+
+/*
+ * Replace the current table by one of the given capacity, leaving the current
+ * one to be migrated. Anything yet to be migrated must be moved first, and in
+ * the time the new table gets all entries of the old one, it cannot be filled
+ * up: it grows by at most capacity / HM_MIGRATE_STEP entries meanwhile.
+ */
+static void rehash_(hashmap* hm, size_t capacity)
+{
+    migrate_(hm, SIZE_MAX);
+    hm->old = hm->cur;
+    hm->migrated = 0;
+    table_init_(hm, &hm->cur, capacity);
+}
+
+// make room for one more entry, reclaiming deleted slots if they are plenty
+static void grow_(hashmap* hm)
+{
+    size_t capacity = hm->cur.capacity;
+    if(hm->cur.length + hm->old.length >= capacity * 7 / 16)
+        capacity *= 2;
+    rehash_(hm, capacity);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public Interfaces
+
+hashmap* hm_create_(size_t szkey, size_t szval, hasher hash, comparator cmp)
+{
+    hashmap* hm = (hashmap*)malloc(sizeof(hashmap));
+    if(!hm) toss(MemoryError);
+    memset(hm, 0, sizeof(hashmap));
+
+    hm->key_size = szkey;
+    hm->val_size = szval;
+    hm->hash = hash;
+    hm->cmp = cmp;
+
+    size_t alkey = align_of_(szkey), alval = align_of_(szval);
+    hm->val_offset = round_up_(szkey, alval);
+    hm->slot_size = round_up_(hm->val_offset + szval,
+            alkey > alval ? alkey : alval);
+    table_init_(hm, &hm->cur, HM_MIN_CAPACITY);
+
+    return hm;
+}
+
+void hm_destroy(hashmap* hm)
+{
+    table_free_(&hm->cur);
+    table_free_(&hm->old);
+    free(hm);
+}
+
+size_t hm_length(hashmap* hm)
+{
+    return hm->cur.length + hm->old.length;
+}
+
+void* hm_get(hashmap* hm, void const* key)
+{
+    uint64_t h = hm->hash(key);
+
+    size_t i = table_find_(hm, &hm->cur, key, h);
+    if(i != NOT_FOUND)
+        return slot_at(hm, &hm->cur, i) + hm->val_offset;
+
+    if(hm->old.capacity) {
+        i = table_find_(hm, &hm->old, key, h);
+        if(i != NOT_FOUND)
+            return slot_at(hm, &hm->old, i) + hm->val_offset;
+    }
+
+    return NULL;
+}
+
+void hm_set(hashmap* hm, void const* key, void const* val)
+{
+    migrate_(hm, HM_MIGRATE_STEP);
+    uint64_t h = hm->hash(key);
+
+    size_t i = table_find_(hm, &hm->cur, key, h);
+    if(i == NOT_FOUND) {
+        if(hm->old.capacity) {
+            // not migrated yet, then move it by hand
+            size_t j = table_find_(hm, &hm->old, key, h);
+            if(j != NOT_FOUND) table_erase_(&hm->old, j);
+        }
+        if(!hm->cur.growth_left) grow_(hm);
+
+        i = table_claim_(&hm->cur, h);
+        memcpy(slot_at(hm, &hm->cur, i), key, hm->key_size);
+    }
+
+    memcpy(slot_at(hm, &hm->cur, i) + hm->val_offset, val, hm->val_size);
+}
+
+void hm_unset(hashmap* hm, void const* key)
+{
+    if(hm_try_unset(hm, key)) toss(KeyNotFound);
+}
+
+ds_error hm_try_unset(hashmap* hm, void const* key)
+{
+    migrate_(hm, HM_MIGRATE_STEP);
+    uint64_t h = hm->hash(key);
+
+    size_t i = table_find_(hm, &hm->cur, key, h);
+    if(i != NOT_FOUND) {
+        table_erase_(&hm->cur, i);
+        return DS_OK;
+    }
+
+    if(hm->old.capacity) {
+        i = table_find_(hm, &hm->old, key, h);
+        if(i != NOT_FOUND) {
+            table_erase_(&hm->old, i);
+            return DS_OK;
+        }
+    }
+
+    return DS_KEY_NOT_FOUND;
+}
+
+void hm_reserve(hashmap* hm, size_t length)
+{
+    size_t capacity = hm->cur.capacity;
+    while(capacity - capacity / 8 < length)
+        capacity *= 2;
+    if(capacity == hm->cur.capacity) return;
+
+    rehash_(hm, capacity);
+    migrate_(hm, SIZE_MAX);
+}
+
+void hm_traverse(hashmap* hm,
+        void (*cb) (void* key, void* val, void* usr), void* usr)
+{
+    hm_table* tables[] = { &hm->cur, &hm->old };
+    for(int k = 0; k < 2; k++) {
+        hm_table* t = tables[k];
+        for(size_t i = 0; i < t->capacity; i++) {
+            if(t->ctrl[i] < 0) continue;
+            uint8_t* s = slot_at(hm, t, i);
+            cb(s, s + hm->val_offset, usr);
+        }
+    }
+}
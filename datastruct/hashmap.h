@@ -0,0 +1,68 @@
+/*
+ * Copyright(c) 2015, Shihira Fung <fengzhiping@hotmail.com>
+ */
+
+#ifndef HASHMAP_H_INCLUDED
+#define HASHMAP_H_INCLUDED
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "utils.h"
+#include "exception.h"
+
+/*
+ * hashmap is an open-addressing hash table in the manner of Swiss tables.
+ * Every slot has a control byte: EMPTY, DELETED, or 7 bits of the hash of its
+ * key. A lookup probes HM_GROUP control bytes at a time, comparing all of them
+ * with the 7 bits at once (by SSE2 where available), and calls cmp only on
+ * slots that match, stopping at the first group with an empty slot.
+ *
+ * Growing doesn't rehash everything at once: the full table is kept as `old`,
+ * and every following hm_set or hm_unset moves a few slots of it into the new
+ * table, while lookups search both tables. Entries (keys followed by values)
+ * therefore move, and pointers from hm_get are valid only until the next
+ * hm_set or hm_unset.
+ */
+
+#define HM_GROUP 16
+#define HM_MIN_CAPACITY 16
+#define HM_MIGRATE_STEP 64 // old slots moved by every update while resizing
+
+typedef struct hm_table_t_ {
+    int8_t* ctrl; // capacity + HM_GROUP, the first group mirrored at the end
+    uint8_t* slots;
+    size_t capacity; // a power of 2
+    size_t length;
+    size_t growth_left; // free slots before reaching the maximum load
+} hm_table;
+
+typedef struct hashmap_t_ {
+    size_t key_size;
+    size_t val_size;
+    size_t val_offset; // values are aligned in a slot
+    size_t slot_size;
+    hasher hash;
+    comparator cmp; // keys are equal if cmp returns 0
+    hm_table cur;
+    hm_table old; // zero capacity if not resizing
+    size_t migrated; // slots of old that have been moved
+} hashmap;
+
+hashmap* hm_create_(size_t szkey, size_t szval, hasher hash, comparator cmp);
+void hm_destroy(hashmap* hm);
+size_t hm_length(hashmap* hm);
+
+void* hm_get(hashmap* hm, void const* key);
+void hm_set(hashmap* hm, void const* key, void const* val);
+void hm_unset(hashmap* hm, void const* key);
+ds_error hm_try_unset(hashmap* hm, void const* key);
+void hm_reserve(hashmap* hm, size_t length);
+// entries come in no particular order, and must not be modified meanwhile
+void hm_traverse(hashmap* hm,
+        void (*cb) (void* key, void* val, void* usr), void* usr);
+
+#define hm_create(ktype, vtype, hash, cmp) \
+    hm_create_(sizeof(ktype), sizeof(vtype), hash, cmp)
+
+#endif // HASHMAP_H_INCLUDED
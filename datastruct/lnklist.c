@@ -7,14 +7,57 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "dsstat.h"
 #include "exception.h"
 
+static lnklist_node* ll_new_node_(lnklist* ll)
+{
+    lnklist_node* n = ll->pool ? (lnklist_node*) mp_alloc(ll->pool) :
+        (lnklist_node*) malloc(sizeof(lnklist_node) + ll->elem_size);
+    if(!n) toss(MemoryError);
+    ds_stat_alloc(DS_STAT_LNKLIST, sizeof(lnklist_node) + ll->elem_size);
+    return n;
+}
+
+static void ll_free_node_(lnklist* ll, lnklist_node* n)
+{
+    if(ll->pool) mp_free(ll->pool, n);
+    else free(n);
+    ds_stat_free(DS_STAT_LNKLIST);
+}
+
+mempool* ll_pool_create_(size_t szelem)
+{ return mp_create(sizeof(lnklist_node) + szelem); }
+
+lnklist* ll_create_pooled_(size_t szelem, mempool* pool)
+{
+    lnklist* ll = (lnklist*) malloc(sizeof(lnklist));
+
+    if(!ll) toss(MemoryError);
+    ll->elem_size = szelem;
+    ll->length = 0;
+    ll->own_pool = !pool;
+    ll->pool = pool ? pool : ll_pool_create_(szelem);
+    if(ll->pool->block_size < sizeof(lnklist_node) + szelem)
+        toss(InvalidPool);
+
+    // past-the-end node
+    ll->head = ll->tail = ll_new_node_(ll);
+    ll->head->next = NULL;
+    ll->head->prev = NULL;
+    ll->head->data = NULL;
+
+    return ll;
+}
+
 lnklist* ll_create_(size_t szelem)
 {
     lnklist* ll = (lnklist*) malloc(sizeof(lnklist));
 
     if(!ll) toss(MemoryError);
     ll->elem_size = szelem;
+    ll->pool = NULL;
+    ll->own_pool = 0;
     ll->head = (lnklist_node*) malloc(sizeof(lnklist_node));
     ll->tail = ll->head;
     ll->length = 0;
@@ -36,10 +79,16 @@ int ll_is_end(const ll_iter n)
 
 void ll_destroy(lnklist* ll)
 {
+    if(ll->own_pool) {
+        mp_destroy(ll->pool);
+        free(ll);
+        return;
+    }
+
     lnklist_node* cur = ll->head;
     while(cur) {
         lnklist_node* nxt = cur->next;
-        free(cur);
+        ll_free_node_(ll, cur);
         cur = nxt;
     }
 
@@ -48,9 +97,7 @@ void ll_destroy(lnklist* ll)
 
 void ll_insert_bef(lnklist* ll, ll_iter cur, void* data)
 {
-    lnklist_node* new_nd = (lnklist_node*)
-        malloc(sizeof(lnklist_node) + ll->elem_size);
-    if(!new_nd) toss(MemoryError);
+    lnklist_node* new_nd = ll_new_node_(ll);
     new_nd->data = (unsigned char*)(new_nd + 1);
     if(data) memcpy(new_nd->data, data, ll->elem_size);
 
@@ -78,6 +125,7 @@ size_t ll_move_bef(lnklist* dst, lnklist* src,
         ll_iter idst, ll_iter isrc, size_t count)
 {
     if(ll_is_end(isrc)) return 0;
+    if(dst->pool != src->pool) toss(PoolMismatch);
 
     ll_iter isrc_lst = isrc;
 
@@ -121,7 +169,7 @@ void ll_remove(lnklist* ll, ll_iter i)
         i->next->prev = i->prev;
     }
 
-    free(i);
+    ll_free_node_(ll, i);
     ll->length--;
 }
 
@@ -134,9 +182,17 @@ size_t ll_length(const lnklist* ll)
 
 ll_iter ll_iter_at(lnklist* ll, size_t pos)
 {
-    lnklist_node* cur = ll->head;
-    for(; pos > 0 && !ll_is_end(cur); pos--)
-        cur = cur->next;
+    if(pos >= ll->length) return ll->tail;
+
+    lnklist_node* cur;
+    if(pos <= ll->length / 2) {
+        for(cur = ll->head; pos > 0; pos--)
+            cur = cur->next;
+    } else {
+        // closer to the tail, walk backwards
+        for(cur = ll->tail, pos = ll->length - pos; pos > 0; pos--)
+            cur = cur->prev;
+    }
     return cur;
 }
 
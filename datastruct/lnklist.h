@@ -7,6 +7,8 @@
 
 #include <stddef.h>
 
+#include "mempool.h"
+
 /*
  * Tips:
  *
@@ -15,6 +17,12 @@
  *     for(ll_iter i = l->head; !ll_is_end(i); i = i->next) {
  *         // ...
  *     }
+ *
+ * - A pooled list takes its nodes, header and payload in one block, from a
+ *   mempool. Created with a NULL pool, the list owns a private pool and
+ *   ll_destroy releases it slab by slab instead of node by node. Lists sharing
+ *   a pool from ll_pool_create must be destroyed before the pool. Nodes can
+ *   be moved only between lists allocating from the same pool (or malloc).
  */
 
 typedef struct lnklist_node_t_ {
@@ -28,9 +36,13 @@ typedef struct lnklist_t_ {
     size_t length; // no additional function besides counter
     lnklist_node* head;
     lnklist_node* tail;
+    mempool* pool; // NULL if nodes are malloc'd
+    int own_pool;
 } lnklist;
 
 lnklist* ll_create_(size_t szelem);
+lnklist* ll_create_pooled_(size_t szelem, mempool* pool);
+mempool* ll_pool_create_(size_t szelem);
 void ll_destroy(lnklist* ll);
 size_t ll_length(const lnklist* ll);
 
@@ -47,5 +59,7 @@ void* ll_at(lnklist* ll, size_t pos);
 int ll_is_end(const ll_iter n);
 
 #define ll_create(type) ll_create_(sizeof(type))
+#define ll_create_pooled(type, pool) ll_create_pooled_(sizeof(type), pool)
+#define ll_pool_create(type) ll_pool_create_(sizeof(type))
 
 #endif // LNKLIST_H_INCLUDED
@@ -0,0 +1,74 @@
+/*
+ * Copyright(c) 2015, Shihira Fung <fengzhiping@hotmail.com>
+ */
+
+#include <stdlib.h>
+
+#include "dsstat.h"
+#include "exception.h"
+#include "mempool.h"
+
+#define align_up(n) (((n) + MP_ALIGN - 1) / MP_ALIGN * MP_ALIGN)
+
+mempool* mp_create(size_t szblock)
+{
+    mempool* mp = (mempool*) malloc(sizeof(mempool));
+    if(!mp) toss(MemoryError);
+
+    if(szblock < sizeof(void*)) szblock = sizeof(void*);
+    mp->block_size = align_up(szblock);
+    mp->slab_blocks = MP_MIN_SLAB;
+    mp->slabs = NULL;
+    mp->free_list = NULL;
+    mp->carve = mp->carve_end = NULL;
+
+    return mp;
+}
+
+void* mp_alloc(mempool* mp)
+{
+    if(mp->free_list) {
+        void* block = mp->free_list;
+        mp->free_list = *(void**)block;
+        return block;
+    }
+
+    if(mp->carve == mp->carve_end) {
+        // blocks of a new slab are carved lazily instead of being threaded
+        // onto the free list all at once
+        unsigned char* slab = (unsigned char*)
+            malloc(align_up(sizeof(void*)) + mp->slab_blocks * mp->block_size);
+        if(!slab) toss(MemoryError);
+        ds_stat_alloc(DS_STAT_MEMPOOL,
+                align_up(sizeof(void*)) + mp->slab_blocks * mp->block_size);
+
+        *(void**)slab = mp->slabs;
+        mp->slabs = slab;
+        mp->carve = slab + align_up(sizeof(void*));
+        mp->carve_end = mp->carve + mp->slab_blocks * mp->block_size;
+
+        if(mp->slab_blocks < MP_MAX_SLAB) mp->slab_blocks *= 2;
+    }
+
+    void* block = mp->carve;
+    mp->carve += mp->block_size;
+    return block;
+}
+
+void mp_free(mempool* mp, void* block)
+{
+    *(void**)block = mp->free_list;
+    mp->free_list = block;
+}
+
+void mp_destroy(mempool* mp)
+{
+    while(mp->slabs) {
+        void* next = *(void**)mp->slabs;
+        free(mp->slabs);
+        ds_stat_free(DS_STAT_MEMPOOL);
+        mp->slabs = next;
+    }
+
+    free(mp);
+}
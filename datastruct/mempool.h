@@ -0,0 +1,37 @@
+/*
+ * Copyright(c) 2015, Shihira Fung <fengzhiping@hotmail.com>
+ */
+
+#ifndef MEMPOOL_H_INCLUDED
+#define MEMPOOL_H_INCLUDED
+
+#include <stddef.h>
+
+/*
+ * mempool hands out fixed-size blocks carved from large slabs. Allocation and
+ * deallocation are O(1) (a free list), and destroying the pool releases whole
+ * slabs at once no matter how many blocks are still in use.
+ *
+ * Slabs grow geometrically from MP_MIN_SLAB to MP_MAX_SLAB blocks, so a pool
+ * serving only a handful of blocks stays small.
+ */
+
+#define MP_MIN_SLAB 8
+#define MP_MAX_SLAB 4096
+#define MP_ALIGN 16
+
+typedef struct mempool_t_ {
+    size_t block_size;
+    size_t slab_blocks; // number of blocks in the next slab
+    void* slabs; // singly linked through the first word of each slab
+    void* free_list; // singly linked through the first word of each block
+    unsigned char* carve; // unused tail of the newest slab
+    unsigned char* carve_end;
+} mempool;
+
+mempool* mp_create(size_t szblock);
+void* mp_alloc(mempool* mp);
+void mp_free(mempool* mp, void* block);
+void mp_destroy(mempool* mp);
+
+#endif // MEMPOOL_H_INCLUDED
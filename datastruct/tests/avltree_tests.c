@@ -1,8 +1,9 @@
-// cflags: bintree.c avltree.c exception.c utils.c
+// cflags: bintree.c mempool.c avltree.c varray.c exception.c utils.c -pthread
 
 #include "../avltree.h"
 
 #include <stdio.h>
+#include <pthread.h>
 
 void print_str_int(btnode* n, void* usr)
 {
@@ -12,6 +13,33 @@ void print_str_int(btnode* n, void* usr)
             entryof(n)->height);
 }
 
+void print_int_int(btnode* n, void* usr)
+{
+    printf("%d -> %d (%d)\n",
+            *(int*)entryof(n)->key,
+            *(int*)entryof(n)->val,
+            entryof(n)->height);
+}
+
+void sum_init(void* aggr, void const * key, void const * val)
+{ *(long*)aggr = *(int*)val; }
+void sum_merge(void* aggr, void const * right)
+{ *(long*)aggr += *(long const*)right; }
+
+typedef struct { bintree* tree; int quarter; } quarter_arg;
+
+void* set_quarter(void* usr)
+{
+    quarter_arg* arg = (quarter_arg*)usr;
+    for(int k = arg->quarter; k < 1000; k += 4) {
+        int v = k * 2;
+        avl_set_ts(arg->tree, &k, &v);
+        avl_get_ts(arg->tree, &k, &v);
+        if(k % 3 == 0) avl_unset_ts(arg->tree, &k);
+    }
+    return NULL;
+}
+
 #define print_tree(t) bt_traverse(t->root, lpr, print_str_int, 0); puts("");
 
 int main()
@@ -39,5 +67,75 @@ int main()
     print_tree(map);
 
     avl_destroy(map);
+
+    ////////////////////////////////////////////// Build from sorted
+
+    typedef struct { int k, v; } kv;
+    varray* sorted = va_create(kv);
+    for(int i = 0; i < 10; i++) {
+        kv e = { i * 10, i };
+        va_append(sorted, &e);
+    }
+
+    bintree* ints = avl_create(int, int, cmpi);
+    avl_build_sorted(ints, sorted);
+    int k = 35, v = -1;
+    avl_set(ints, &k, &v);
+    avl_unset(ints, refi(0));
+    bt_traverse(ints->root, lpr, print_int_int, 0); puts("");
+
+    avl_destroy(ints);
+    va_destroy(sorted);
+
+    ////////////////////////////////////////////// Order statistics
+
+    avl_aggr sum = { sizeof(long), sum_init, sum_merge };
+    ints = avl_create_aggr(int, int, cmpi, &sum);
+    for(k = 0; k < 100; k++) {
+        v = k * k;
+        avl_set(ints, &k, &v);
+    }
+    for(k = 0; k < 100; k += 3) avl_unset(ints, &k);
+    v = -100;
+    avl_set(ints, refi(50), &v);
+
+    printf("rank(50): %lu, rank(51): %lu, rank(1000): %lu\n",
+            avl_rank(ints, refi(50)), avl_rank(ints, refi(51)),
+            avl_rank(ints, refi(1000)));
+    for(size_t i = 0; i < 66; i += 13)
+        printf("select(%lu): %d\n", i, *(int*)entryof(avl_select(ints, i))->key);
+    printf("select(66): %p\n", (void*)avl_select(ints, 66));
+
+    int ranges[][2] = { { 0, 100 }, { 10, 20 }, { 49, 52 }, { 3, 4 } };
+    for(size_t i = 0; i < 4; i++) {
+        long total = 0;
+        size_t count = avl_range_aggr(ints,
+                &ranges[i][0], &ranges[i][1], &total);
+        printf("[%d, %d): %lu entries, sum %ld\n",
+                ranges[i][0], ranges[i][1], count, total);
+    }
+
+    avl_destroy(ints);
+
+    ////////////////////////////////////////////// Thread-safe access
+
+    ints = avl_create(int, int, cmpi);
+    pthread_t threads[4];
+    quarter_arg args[4];
+    for(int i = 0; i < 4; i++) {
+        args[i].tree = ints;
+        args[i].quarter = i;
+        pthread_create(threads + i, NULL, set_quarter, args + i);
+    }
+    for(int i = 0; i < 4; i++)
+        pthread_join(threads[i], NULL);
+
+    size_t count = 0;
+    for(int k = 0; k < 1000; k++)
+        count += avl_get_ts(ints, &k, &v);
+    printf("%lu keys, unset 999: %d, unset 998: %d\n", count,
+            avl_unset_ts(ints, refi(999)), avl_unset_ts(ints, refi(998)));
+
+    avl_destroy(ints);
 }
 
@@ -0,0 +1,71 @@
+// cflags: b_file.c exception.c utils.c
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "../b_file.h"
+#include "../exception.h"
+
+#define PATH "/tmp/b_file_tests.db"
+
+void print_lookups(b_file* bf)
+{
+    int keys[] = { 0, 1, 2, 500, 777, 999, 1000, 1998, 4000 };
+    for(size_t i = 0; i < sizeof(keys) / sizeof(int); i++) {
+        int* v = (int*)bf_get(bf, keys + i);
+        if(v) printf("%d -> %d\n", keys[i], *v);
+        else printf("%d -> (none)\n", keys[i]);
+    }
+    printf("length: %lu\n\n", bf_length(bf));
+}
+
+int main()
+{
+    unlink(PATH);
+
+    // small pages so that the tree gets a few levels
+    b_file* bf = bf_open(PATH, sizeof(int), sizeof(int), cmpi,
+            128, BF_SYNC_MANUAL);
+    for(int i = 0; i < 1000; i++) {
+        int k = (i * 7919) % 1000 * 2, v = i;
+        bf_set(bf, &k, &v);
+    }
+    print_lookups(bf);
+    bf_close(bf);
+
+    // reopened with another page size, which is ignored for existing files
+    bf = bf_open(PATH, sizeof(int), sizeof(int), cmpi,
+            BF_DEFAULT_PAGE, BF_SYNC_EACH);
+    print_lookups(bf);
+
+    for(int k = 0; k < 1000; k += 2) bf_unset(bf, &k);
+    int k = 777, v = -1;
+    bf_set(bf, &k, &v);
+    bf_close(bf);
+
+    bf = bf_open(PATH, sizeof(int), sizeof(int), cmpi,
+            BF_DEFAULT_PAGE, BF_SYNC_ASYNC);
+    print_lookups(bf);
+
+    examine { bf_unset(bf, refi(1)); }
+    grab(KeyNotFound) { printf("KeyNotFound\n"); }
+    bf_close(bf);
+
+    examine { bf = bf_open(PATH, sizeof(int), sizeof(double), cmpi,
+            BF_DEFAULT_PAGE, BF_SYNC_MANUAL); }
+    grab(IncompatibleFile) { printf("IncompatibleFile\n"); }
+
+    // a file cut short of its pages
+    truncate(PATH, 64);
+    examine { bf = bf_open(PATH, sizeof(int), sizeof(int), cmpi,
+            BF_DEFAULT_PAGE, BF_SYNC_MANUAL); }
+    grab(IncompatibleFile) { printf("IncompatibleFile\n"); }
+
+    truncate(PATH, 4);
+    examine { bf = bf_open(PATH, sizeof(int), sizeof(int), cmpi,
+            BF_DEFAULT_PAGE, BF_SYNC_MANUAL); }
+    grab(IncompatibleFile) { printf("IncompatibleFile\n"); }
+
+    unlink(PATH);
+    return 0;
+}
@@ -1,7 +1,9 @@
-// cflags: b_tree.c exception.c lnklist.c utils.c -gdwarf-2 -g3
+// cflags: b_tree.c varray.c exception.c utils.c -gdwarf-2 -g3 -pthread
 
 #include <stdio.h>
 #include <string.h>
+#include <limits.h>
+#include <pthread.h>
 
 #include "../b_tree.h"
 #include "../exception.h"
@@ -17,20 +19,59 @@ void print_entry_str_int(b_entry* e, void* usr)
     );
 }
 
+void print_entry_int_int(b_entry* e, void* usr)
+{
+    printf("%d -> %d\n", *(int*)e->key, *(int*)e->val);
+}
+
 void print_tree_node(b_node* n, int height)
 {
     if(!n) return;
-    for(ll_iter i = n->entries->head;
-            !ll_is_end(i); i = i->next) {
-        print_tree_node(((b_entry*)i->data)->left, height + 1);
+    if(!n->leaf) {
+        for(size_t i = 0; i <= n->nkeys; i++)
+            print_tree_node(n->children[i], height + 1);
+        return;
+    }
+    for(size_t i = 0; i < n->nkeys; i++) {
         void* param[] = { n, (void*)(uint64_t)height };
-        print_entry_str_int((b_entry*)i->data, &param);
+        b_entry e = { n->keys + i * n->key_size, n->vals + i * n->val_size };
+        print_entry_str_int(&e, &param);
     }
-    print_tree_node(n->right, height + 1);
 }
+typedef struct { b_tree* tree; int quarter; } quarter_arg;
+
+void* set_quarter(void* usr)
+{
+    quarter_arg* arg = (quarter_arg*)usr;
+    for(int k = arg->quarter; k < 1000; k += 4) {
+        int v = k * 2;
+        b_set_ts(arg->tree, &k, &v);
+        b_get_ts(arg->tree, &k, &v);
+        if(k % 3 == 0) b_unset_ts(arg->tree, &k);
+    }
+    return NULL;
+}
+
 //#define print_tree(b_t) (b_traverse(b_t->root, lpr, print_entry_str_int, NULL), putchar('\n'))
 #define print_tree(b_t) (print_tree_node(b_t->root, 1), putchar('\n'))
 
+void print_block(b_entry* es, size_t count, void* usr)
+{
+    (void)usr;
+    printf("[%lu]", count);
+    for(size_t i = 0; i < count; i++)
+        printf(" %d%s", *(int*)es[i].key, es[i].val ? "" : "*");
+    putchar('\n');
+}
+
+void count_block(b_entry* es, size_t count, void* usr)
+{
+    (void)es;
+    size_t* n = (size_t*)usr;
+    n[0]++;
+    n[1] += count;
+}
+
 int main()
 {
     b_tree* b_t = b_create(3, char*, int, cmps);
@@ -64,4 +105,106 @@ int main()
     b_unset(b_t, refs("Computer"));   print_tree(b_t);
 
     b_destroy(b_t);
+
+    ////////////////////////////////////////////// Range Scan
+
+    b_t = b_create(4, int, int, cmpi);
+    for(int i = 0; i < 40; i += 2) b_set(b_t, &i, refi(i * i));
+
+    b_entry e;
+    if(b_lower_bound(b_t, refi(7), &e))
+        printf("lower bound of 7: %d -> %d\n", *(int*)e.key, *(int*)e.val);
+    if(!b_lower_bound(b_t, refi(39), &e))
+        puts("no lower bound of 39");
+    int lo = 11, hi = 21;
+    printf("%lu in [11, 21)\n", b_range(b_t, &lo, &hi,
+                print_entry_int_int, NULL));
+    putchar('\n');
+
+    // page through [5, 31) by 3 entries, modifying the tree between pages
+    int begin = 5, end = 31;
+    b_cursor* c = b_cursor_open(b_t, &begin, &end);
+    for(int page = 0, more = 1; more; page++) {
+        printf("page %d:", page);
+        for(int n = 0; n < 3 && (more = b_cursor_next(c, &e)); n++)
+            printf(" %d", *(int*)e.key);
+        putchar('\n');
+
+        for(int k = page * 5 + 10; k < page * 5 + 15; k++)
+            if(k % 2) b_set(b_t, &k, &k); else b_unset(b_t, &k);
+    }
+    b_cursor_close(c);
+
+    // keys far apart must be ordered the same by scans and by searches
+    b_tree* ext = b_create(4, int, int, cmpi);
+    int extremes[] = { INT_MIN, 1, 2, 5, INT_MAX };
+    for(int i = 0; i < 5; i++)
+        b_set(ext, extremes + i, refi(i));
+    lo = INT_MIN; hi = 3;
+    printf("%lu in [INT_MIN, 3)\n", b_range(ext, &lo, &hi,
+                print_entry_int_int, NULL));
+    b_destroy(ext);
+
+    b_destroy(b_t);
+
+    ////////////////////////////////////////////// Bulk Loading
+
+    typedef struct { int k, v; } kv;
+    varray* sorted = va_create(kv);
+    for(int i = 0; i < 30; i++) {
+        kv e = { i * 10, i };
+        va_append(sorted, &e);
+    }
+
+    b_t = b_create(5, int, int, cmpi);
+    b_bulk_load(b_t, sorted, 0.75);
+    int k = 35, v = -1;
+    b_set(b_t, &k, &v);
+    b_unset(b_t, refi(0));
+    for(b_node* n = b_t->root; n; n = n->leaf ? NULL : n->children[0])
+        printf("%s of %lu keys\n", n->leaf ? "leaf" : "node", n->nkeys);
+    printf("%lu entries, 35 -> %d, 290 -> %d\n", b_t->length,
+            *(int*)b_get(b_t, refi(35)), *(int*)b_get(b_t, refi(290)));
+
+    ////////////////////////////////////////////// Batch Traversal
+
+    // routing keys are marked with *
+    b_traverse_batch(b_t->root, plr, print_block, NULL);
+    b_traverse_batch(b_t->root, lrp, print_block, NULL);
+    b_destroy(b_t);
+
+    b_t = b_create(3, int, int, cmpi);
+    for(k = 0; k < 10000; k++)
+        b_set(b_t, &k, &k);
+    size_t blocks[2] = { 0, 0 };
+    b_traverse_batch(b_t->root, lpr, count_block, blocks);
+    printf("%lu entries in %lu blocks\n", blocks[1], blocks[0]);
+
+    // b_tree has no reversed orders
+    examine { b_traverse_batch(b_t->root, rlp, count_block, blocks); }
+    grab(InvalidOrder) { printf("rlp: %s\n", except_status.desc); }
+
+    b_destroy(b_t);
+    va_destroy(sorted);
+
+    ////////////////////////////////////////////// Thread-safe Access
+
+    b_t = b_create(4, int, int, cmpi);
+    pthread_t threads[4];
+    quarter_arg args[4];
+    for(int i = 0; i < 4; i++) {
+        args[i].tree = b_t;
+        args[i].quarter = i;
+        pthread_create(threads + i, NULL, set_quarter, args + i);
+    }
+    for(int i = 0; i < 4; i++)
+        pthread_join(threads[i], NULL);
+
+    size_t count = 0;
+    for(k = 0; k < 1000; k++)
+        count += b_get_ts(b_t, &k, &v);
+    printf("%lu keys, unset 999: %d, unset 998: %d\n", count,
+            b_unset_ts(b_t, refi(999)), b_unset_ts(b_t, refi(998)));
+
+    b_destroy(b_t);
 }
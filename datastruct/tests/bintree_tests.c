@@ -1,4 +1,4 @@
-// cflags: exception.c bintree.c utils.c
+// cflags: exception.c bintree.c mempool.c utils.c
 
 #include "../bintree.h"
 #include "../utils.h"
@@ -9,6 +9,22 @@ void print_node(btnode* n, void* usr)
     printf("%d ", *(int*)n->data);
 }
 
+void print_block(btnode** ns, size_t count, void* usr)
+{
+    printf("[%lu]", count);
+    for(size_t i = 0; i < count; i++)
+        printf(" %d", *(int*)ns[i]->data);
+    putchar('\n');
+    (void)usr;
+}
+
+void sum_block(btnode** ns, size_t count, void* usr)
+{
+    long* sum = (long*)usr;
+    for(size_t i = 0; i < count; i++)
+        *sum += *(int*)ns[i]->data;
+}
+
 int main()
 {
     /*
@@ -46,7 +62,23 @@ int main()
     n[13] = bt_rchild(n[3 ], bt_new_node(bt, refi(13)));
     n[14] = bt_lchild(n[13], bt_new_node(bt, refi(14)));
 
-    bt_traverse(n[0], prl, print_node, NULL); putchar('\n');
+    traverse_order orders[] = { plr, lpr, prl, rpl, lrp, rlp };
+    for(int i = 0; i < 6; i++) {
+        bt_traverse(n[0], orders[i], print_node, NULL);
+        putchar('\n');
+    }
+    bt_traverse_batch(n[1], lpr, print_block, NULL);
+
+    bt_destroy(bt);
+
+    // a degenerate tree far deeper than the call stack allows
+    bt = bt_create(int, refi(0));
+    btnode* tail = bt->root;
+    for(int i = 1; i < 1000000; i++)
+        tail = bt_rchild(tail, bt_new_node(bt, refi(i)));
+    long sum = 0;
+    bt_traverse_batch(bt->root, lrp, sum_block, &sum);
+    printf("sum %ld\n", sum);
 
     bt_destroy(bt);
 }
@@ -0,0 +1,175 @@
+// cflags: lnklist.c mempool.c varray.c vasort.c thrpool.c vaheap.c exception.c graph.c dset.c csr.c utils.c -pthread
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#include "../graph.h"
+#include "../csr.h"
+#include "../utils.h"
+
+#define data_at(c, i) (*(int*)(c)->nodes[i]->data)
+
+void print_node(gnode* n, void* usr)
+{
+    printf("%d ", *(int*)n->data);
+}
+
+void print_index(size_t i, void* usr)
+{
+    printf("%d ", data_at((csr*)usr, i));
+}
+
+void print_hops(gnode* n, int hops, void* usr)
+{
+    printf("%d@%d ", *(int*)n->data, hops);
+}
+
+void print_comp(gnode* n, size_t comp, void* usr)
+{
+    printf("%d@%lu ", *(int*)n->data, comp);
+}
+
+void print_path(csr* c, gnode* sp, gnode* ep)
+{
+    varray* path = va_create(size_t);
+    printf("%d: ", csr_dijkstra(c, csr_index(sp), csr_index(ep), path));
+    for(size_t i = 0; i < path->length; i++)
+        printf("%d ", data_at(c, va_cast(size_t, path)[i]));
+    putchar('\n');
+    va_destroy(path);
+}
+
+int main()
+{
+    // the same graph as in graph_tests, plus an isolated pair 6-7
+    graph* g = g_create(int, UNDIRECTED);
+    gnode* nodes[8];
+
+    for(int i = 0; i < 8; i++)
+        nodes[i] = g_add_node(g, refi(i));
+
+    g_connect(g, nodes[0], nodes[1], 12);
+    g_connect(g, nodes[0], nodes[2], 10);
+    g_connect(g, nodes[0], nodes[4], 7 );
+    g_connect(g, nodes[1], nodes[4], 13);
+    g_connect(g, nodes[2], nodes[3], 9 );
+    g_connect(g, nodes[3], nodes[4], 5 );
+    g_connect(g, nodes[3], nodes[5], 11);
+    g_connect(g, nodes[6], nodes[7], 1 );
+
+    csr* c = g_freeze(g);
+    printf("%lu nodes, %lu adjacencies\n", c->nnodes, c->nadj);
+    for(size_t i = 0; i < c->nnodes; i++) {
+        printf("%d:", data_at(c, i));
+        for(size_t j = c->offsets[i]; j < c->offsets[i + 1]; j++)
+            printf(" %d(%d)", data_at(c, c->nbrs[j]), c->weights[j]);
+        putchar('\n');
+    }
+
+    // the orders must be the same as g_dfs
+    csr_dfs(c, csr_index(nodes[0]), print_index, c); putchar('\n');
+    csr_dfs(c, csr_index(nodes[3]), print_index, c); putchar('\n');
+
+    int hops[8];
+    csr_bfs(c, csr_index(nodes[0]), hops);
+    for(int i = 0; i < 8; i++)
+        printf("%d ", hops[csr_index(nodes[i])]);
+    putchar('\n');
+
+    print_path(c, nodes[0], nodes[5]);
+    print_path(c, nodes[1], nodes[3]);
+    print_path(c, nodes[5], nodes[5]);
+    printf("%s\n", csr_dijkstra(c, csr_index(nodes[0]),
+                csr_index(nodes[6]), NULL) == INT_MAX ? "unreachable" : "?");
+
+    int phops[8];
+    csr_bfs_parallel(c, csr_index(nodes[0]), phops, 4);
+    for(int i = 0; i < 8; i++)
+        printf("%d ", phops[csr_index(nodes[i])]);
+    putchar('\n');
+
+    uint32_t labels[8];
+    printf("%lu components:", csr_components(c, labels, 4));
+    for(int i = 0; i < 8; i++)
+        printf(" %d", data_at(c, labels[csr_index(nodes[i])]));
+    putchar('\n');
+
+    varray* st = va_create(csr_edge);
+    printf("spanning forest of %ld:", csr_mst(c, st));
+    for(size_t i = 0; i < st->length; i++) {
+        csr_edge* e = va_at(st, i);
+        printf(" %d-%d(%d)", data_at(c, e->from), data_at(c, e->to), e->weight);
+    }
+    putchar('\n');
+    va_destroy(st);
+
+    csr_destroy(c);
+
+    g_bfs_parallel(g, nodes[3], 2, print_hops, NULL); putchar('\n');
+    printf("%lu components\n", g_components(g, 2, print_comp, NULL));
+    g_destroy(g);
+
+    ////////////////////////////////////////////// Parallel on a larger graph
+
+    // a chain of 1000 nodes with shortcuts, which switches the BFS to
+    // bottom-up and back, and 10 more components of isolated nodes
+    g = g_create(int, UNDIRECTED);
+    gnode* many[1010];
+    for(int i = 0; i < 1010; i++)
+        many[i] = g_add_node(g, &i);
+    for(int i = 0; i + 1 < 1000; i++) {
+        g_connect(g, many[i], many[i + 1], 1);
+        if(i % 7 == 0) g_connect(g, many[i], many[(i * 37) % 1000], 1);
+    }
+
+    c = g_freeze(g);
+    int* seq = malloc(c->nnodes * sizeof(int));
+    int* par = malloc(c->nnodes * sizeof(int));
+    csr_bfs(c, csr_index(many[500]), seq);
+    size_t differ = 0;
+    for(size_t th = 1; th <= 4; th++) {
+        csr_bfs_parallel(c, csr_index(many[500]), par, th);
+        for(size_t i = 0; i < c->nnodes; i++)
+            differ += seq[i] != par[i];
+    }
+    printf("%lu hops differ, %lu components\n", differ,
+            csr_components(c, (uint32_t*)par, 3));
+    free(par);
+    free(seq);
+    csr_destroy(c);
+    g_destroy(g);
+
+    ////////////////////////////////////////////// Directed
+
+    g = g_create(int, DIRECTED);
+    for(int i = 0; i < 4; i++)
+        nodes[i] = g_add_node(g, refi(i));
+    g_connect(g, nodes[0], nodes[1], 1);
+    g_connect(g, nodes[1], nodes[2], 1);
+    g_connect(g, nodes[0], nodes[2], 5);
+    g_connect(g, nodes[3], nodes[0], 1);
+
+    c = g_freeze(g);
+    for(size_t i = 0; i < c->nnodes; i++) {
+        printf("%d: out", data_at(c, i));
+        for(size_t j = c->offsets[i]; j < c->offsets[i + 1]; j++)
+            printf(" %d", data_at(c, c->nbrs[j]));
+        printf(", in");
+        for(size_t j = c->in_offsets[i]; j < c->in_offsets[i + 1]; j++)
+            printf(" %d", data_at(c, c->in_nbrs[j]));
+        putchar('\n');
+    }
+    print_path(c, nodes[0], nodes[2]);
+    printf("%s\n", csr_dijkstra(c, csr_index(nodes[0]),
+                csr_index(nodes[3]), NULL) == INT_MAX ? "unreachable" : "?");
+    int dhops[4];
+    csr_bfs_parallel(c, csr_index(nodes[0]), dhops, 2);
+    printf("hops %d %d %d %d, ", dhops[csr_index(nodes[0])],
+            dhops[csr_index(nodes[1])], dhops[csr_index(nodes[2])],
+            dhops[csr_index(nodes[3])]);
+    printf("%lu component\n", csr_components(c, (uint32_t*)dhops, 2));
+
+    csr_destroy(c);
+    g_destroy(g);
+}
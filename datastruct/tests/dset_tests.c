@@ -0,0 +1,69 @@
+// cflags: dset.c exception.c utils.c -pthread
+
+#include <stdio.h>
+#include <pthread.h>
+
+#include "../dset.h"
+#include "../exception.h"
+
+void print_sets(dset* ds)
+{
+    printf("%lu sets:", ds->ncomps);
+    for(size_t i = 0; i < ds->length; i++)
+        printf(" %lu", dset_find(ds, i));
+    putchar('\n');
+}
+
+typedef struct { dset* ds; size_t from; } union_arg;
+
+void* union_stride(void* usr)
+{
+    union_arg* arg = (union_arg*)usr;
+    // every thread joins i with i + 4, from a different offset
+    for(size_t i = arg->from; i + 4 < arg->ds->length; i += 4) {
+        dset_union_ts(arg->ds, i, i + 4);
+        dset_union_ts(arg->ds, i + 4, i);
+    }
+    return NULL;
+}
+
+int main()
+{
+    dset* ds = dset_create(10);
+    print_sets(ds);
+
+    printf("%d ", dset_union(ds, 1, 2));
+    printf("%d ", dset_union(ds, 3, 4));
+    printf("%d ", dset_union(ds, 2, 4));
+    printf("%d ", dset_union(ds, 1, 3));
+    printf("%d\n", dset_union(ds, 7, 9));
+    print_sets(ds);
+    printf("same(1, 4): %d, same(0, 9): %d\n",
+            dset_same(ds, 1, 4), dset_same(ds, 0, 9));
+
+    examine { dset_find(ds, 10); }
+    grab(OutOfRange) { printf("OutOfRange\n"); }
+    dset_destroy(ds);
+
+    ////////////////////////////////////////////// Concurrent
+
+    ds = dset_create(10000);
+    pthread_t threads[4];
+    union_arg args[4];
+    for(size_t i = 0; i < 4; i++) {
+        args[i].ds = ds;
+        args[i].from = i;
+        pthread_create(threads + i, NULL, union_stride, args + i);
+    }
+    for(size_t i = 0; i < 4; i++)
+        pthread_join(threads[i], NULL);
+
+    // residues 0 and 1 modulo 4 are then bridged once
+    printf("%lu sets, ", ds->ncomps);
+    printf("%d ", dset_union_ts(ds, 9996, 9997));
+    printf("%d ", dset_union_ts(ds, 0, 1));
+    printf("%lu sets, roots %lu %lu %lu %lu\n", ds->ncomps,
+            dset_find_ts(ds, 9999), dset_find_ts(ds, 9998),
+            dset_find_ts(ds, 5), dset_find_ts(ds, 4));
+    dset_destroy(ds);
+}
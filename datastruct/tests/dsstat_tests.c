@@ -0,0 +1,66 @@
+// cflags: dsstat.c varray.c vasort.c vaheap.c bintree.c mempool.c avltree.c b_tree.c hashmap.c exception.c utils.c -pthread -DDS_STATS
+
+#include <stdio.h>
+
+#include "../dsstat.h"
+#include "../varray.h"
+#include "../vasort.h"
+#include "../vaheap.h"
+#include "../avltree.h"
+#include "../b_tree.h"
+#include "../hashmap.h"
+
+int main()
+{
+    varray* va = va_create(int);
+    for(int i = 0; i < 100; i++)
+        va_append(va, refi(i * 37 % 100));
+    printf("varray reallocs: %lu, bytes: %lu\n",
+            ds_stat_get(DS_STAT_VARRAY, DS_STAT_REALLOCS),
+            ds_stat_get(DS_STAT_VARRAY, DS_STAT_BYTES));
+    va_introsort(va, (va_cmp)cmpi);
+    printf("varray compares: %d\n",
+            ds_stat_get(DS_STAT_VARRAY, DS_STAT_COMPARES) > 0);
+    va_heapify(va, (va_cmp)cmpi);
+    printf("vaheap sifts: %lu\n", ds_stat_get(DS_STAT_VAHEAP, DS_STAT_SIFTS));
+    va_destroy(va);
+
+    // ascending keys rotate at every power of 2
+    bintree* avl = avl_create(int, int, cmpi);
+    for(int i = 0; i < 7; i++)
+        avl_set(avl, &i, &i);
+    printf("avltree rotations: %lu, bintree allocs: %lu\n",
+            ds_stat_get(DS_STAT_AVLTREE, DS_STAT_ROTATIONS),
+            ds_stat_get(DS_STAT_BINTREE, DS_STAT_ALLOCS));
+    avl_destroy(avl);
+
+    b_tree* b_t = b_create(4, int, int, cmpi);
+    for(int i = 0; i < 100; i++)
+        b_set(b_t, &i, &i);
+    for(int i = 0; i < 100; i++)
+        b_unset(b_t, &i);
+    printf("b_tree allocs - frees: %lu, splits: %d, merges: %d\n",
+            ds_stat_get(DS_STAT_B_TREE, DS_STAT_ALLOCS) -
+            ds_stat_get(DS_STAT_B_TREE, DS_STAT_FREES),
+            ds_stat_get(DS_STAT_B_TREE, DS_STAT_SPLITS) > 0,
+            ds_stat_get(DS_STAT_B_TREE, DS_STAT_MERGES) > 0);
+    printf("b_tree compares: %d\n",
+            ds_stat_get(DS_STAT_B_TREE, DS_STAT_COMPARES) > 0);
+    b_destroy(b_t);
+
+    hashmap* hm = hm_create(int, int, hashi, cmpi);
+    for(int i = 0; i < 10; i++)
+        hm_set(hm, &i, &i);
+    hm_destroy(hm);
+    printf("hashmap allocs: %lu, frees: %lu\n",
+            ds_stat_get(DS_STAT_HASHMAP, DS_STAT_ALLOCS),
+            ds_stat_get(DS_STAT_HASHMAP, DS_STAT_FREES));
+
+    ds_stat_reset();
+    va = va_create(char);
+    va_destroy(va);
+    ds_stat_dump(stdout);
+
+    examine { ds_stat_get(DS_STAT_NCONTAINERS, DS_STAT_ALLOCS); }
+    grab(OutOfRange) { printf("OutOfRange\n"); }
+}
@@ -0,0 +1,68 @@
+// cflags: exception.c varray.c vasort.c b_tree.c utils.c -pthread
+
+#include <stdio.h>
+#include <pthread.h>
+
+#include "../exception.h"
+#include "../varray.h"
+#include "../b_tree.h"
+
+void* toss_in_thread(void* usr)
+{
+    int caught = 0;
+    for(int i = 0; i < 1000; i++) {
+        examine { if(i % 2) toss(Odd); }
+        grab(Odd) { caught++; }
+    }
+    *(int*)usr = caught;
+    return NULL;
+}
+
+int main()
+{
+    // blocks completing normally give their handlers back
+    int caught = 0;
+    for(int i = 0; i < 1000; i++) {
+        examine { if(i == 999) toss(Last); }
+        grab(Last) { caught++; }
+    }
+    printf("caught %d, %lu handlers left\n", caught, jmp_context_stack_len_);
+
+    examine {
+        examine { toss(Inner); }
+        grab(Outer) { puts("wrong handler"); }
+        toss_else
+    } grab(Inner) { printf("Inner passed outwards, %lu handlers left\n",
+            jmp_context_stack_len_); }
+
+    // every thread has its own handlers
+    pthread_t threads[4];
+    int counts[4];
+    for(int i = 0; i < 4; i++)
+        pthread_create(threads + i, NULL, toss_in_thread, counts + i);
+    for(int i = 0; i < 4; i++)
+        pthread_join(threads[i], NULL);
+    printf("%d %d %d %d\n", counts[0], counts[1], counts[2], counts[3]);
+
+    ////////////////////////////////////////////// Error codes
+
+    varray* va = va_create(int);
+    va_append(va, refi(42));
+    void* elem;
+    ds_error err = va_try_at(va, 0, &elem);
+    printf("%s %d, ", ds_error_tag(err), *(int*)elem);
+    printf("%s, ", ds_error_tag(va_try_at(va, 1, &elem)));
+    printf("%s, ", ds_error_tag(va_try_remove(va, 0)));
+    printf("%s\n", ds_error_tag(va_try_remove(va, 0)));
+    va_destroy(va);
+
+    b_tree* b_t = b_create(4, int, int, cmpi);
+    int k = 1, v = 10;
+    b_set(b_t, &k, &v);
+    err = b_try_get(b_t, &k, &elem);
+    printf("%s %d, ", ds_error_tag(err), *(int*)elem);
+    printf("%s, ", ds_error_tag(b_try_get(b_t, refi(2), &elem)));
+    printf("%s, ", ds_error_tag(b_try_unset(b_t, &k)));
+    printf("%s\n", ds_error_tag(b_try_unset(b_t, &k)));
+    b_destroy(b_t);
+}
@@ -1,6 +1,7 @@
-// cflags: lnklist.c varray.c vaheap.c exception.c graph.c utils.c
+// cflags: lnklist.c mempool.c varray.c vasort.c thrpool.c vaheap.c exception.c graph.c dset.c utils.c -pthread
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "../graph.h"
 #include "../utils.h"
@@ -27,8 +28,56 @@ void quote_pnode_int(varray* str, gnode* n)
     va_printf(str, "\"%d\"", *(int*)(*(gnode**)n->data)->data);
 }
 
+int zero_heuristic(gnode* n, gnode* ep, void* usr)
+{
+    return 0;
+}
+
+// nodes of a grid hold their coordinates y * 100 + x, and every edge weighs
+// at least 1, so manhattan distance never overestimates
+int manhattan(gnode* n, gnode* ep, void* usr)
+{
+    int a = *(int*)n->data, b = *(int*)ep->data;
+    return abs(a / 100 - b / 100) + abs(a % 100 - b % 100);
+}
+
+void grid_tests()
+{
+    graph* g = g_create(int, DIRECTED);
+    gnode* grid[10][10];
+
+    for(int y = 0; y < 10; y++)
+        for(int x = 0; x < 10; x++) {
+            int data = y * 100 + x;
+            grid[y][x] = g_add_node(g, &data);
+        }
+    for(int y = 0; y < 10; y++)
+        for(int x = 0; x < 10; x++) {
+            int w = (x * 7 + y * 13) % 5 + 1;
+            if(x < 9) g_connect(g, grid[y][x], grid[y][x + 1], w);
+            if(y < 9) g_connect(g, grid[y][x], grid[y + 1][x], w);
+            if(x > 0) g_connect(g, grid[y][x], grid[y][x - 1], 6 - w);
+        }
+
+    int pairs[][4] = { { 0, 0, 9, 9 }, { 3, 0, 5, 9 }, { 9, 9, 0, 0 } };
+    for(size_t i = 0; i < 3; i++) {
+        gnode* sp = grid[pairs[i][0]][pairs[i][1]];
+        gnode* ep = grid[pairs[i][2]][pairs[i][3]];
+        lnklist* path = ll_create(gnode*);
+        printf("%d %d ", g_dijkstra(g, sp, ep, NULL),
+                g_astar(g, sp, ep, NULL, manhattan, NULL));
+        printf("%d: ", g_bidijkstra(g, sp, ep, path));
+        print_ll(path);
+        ll_destroy(path);
+    }
+
+    g_destroy(g);
+}
+
 int main()
 {
+    grid_tests();
+
     /*
      *     0-12--1
      *  10/|    /
@@ -80,6 +129,22 @@ int main()
     print_ll(path);
     ll_destroy(path);
 
+    //////////////////////////////////// A* and Bidirectional Dijkstra
+    path = ll_create(gnode*);
+    printf("%d: ", g_astar(g, nodes[0], nodes[5], path, zero_heuristic, NULL));
+    print_ll(path);
+    ll_destroy(path);
+
+    path = ll_create(gnode*);
+    printf("%d: ", g_bidijkstra(g, nodes[0], nodes[5], path));
+    print_ll(path);
+    ll_destroy(path);
+
+    path = ll_create(gnode*);
+    printf("%d: ", g_bidijkstra(g, nodes[1], nodes[3], path));
+    print_ll(path);
+    ll_destroy(path);
+
     //////////////////////////////////// Kruskal's Algo
     graph* spantree = g_create(gnode*, UNDIRECTED);
     g_kruskal(g, spantree);
@@ -90,6 +155,16 @@ int main()
     va_destroy(dot_dump);
     g_destroy(spantree);
 
+    //////////////////////////////////// Boruvka's Algo
+    spantree = g_create(gnode*, UNDIRECTED);
+    g_boruvka(g, spantree, 2);
+
+    dot_dump = va_create(char);
+    g_dump(spantree, dot_dump, quote_pnode_int);
+    printf("Spanning tree:\n%s", dot_dump->data);
+    va_destroy(dot_dump);
+    g_destroy(spantree);
+
     //////////////////////////////////// Prim's Algo
     spantree = g_create(gnode*, UNDIRECTED);
     g_prim(g, spantree);
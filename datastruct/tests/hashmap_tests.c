@@ -0,0 +1,83 @@
+// cflags: hashmap.c exception.c utils.c
+
+#include <stdio.h>
+
+#include "../hashmap.h"
+#include "../exception.h"
+
+void sum_entries(void* key, void* val, void* usr)
+{
+    long* sums = (long*)usr;
+    sums[0] += *(int*)key;
+    sums[1] += *(int*)val;
+}
+
+int main()
+{
+    char const* words[] = { "Hello", "World", "Shihira", "DataStruct",
+        "Trivial", "Tests", "Here Are", "Sentences" };
+    int nwords = sizeof(words) / sizeof(char const*);
+
+    hashmap* hm = hm_create(char const*, int, hashs, cmps);
+    for(int i = 0; i < nwords; i++)
+        hm_set(hm, words + i, refi(i * 11));
+    hm_set(hm, refs("Hello"), refi(100));
+    hm_unset(hm, refs("Trivial"));
+
+    printf("%lu entries\n", hm_length(hm));
+    for(int i = 0; i < nwords; i++) {
+        int* v = (int*)hm_get(hm, words + i);
+        if(v) printf("%s -> %d\n", words[i], *v);
+        else printf("%s not found\n", words[i]);
+    }
+
+    examine { hm_unset(hm, refs("Trivial")); }
+    grab(KeyNotFound) { printf("KeyNotFound\n"); }
+    printf("try_unset: %d\n", hm_try_unset(hm, refs("Trivial")));
+    hm_destroy(hm);
+
+    ////////////////////////////////////////////// Resizing
+
+    hm = hm_create(int, int, hashi, cmpi);
+    size_t reported = 0;
+    for(int i = 0; i < 100000; i++) {
+        hm_set(hm, &i, refi(i * 2));
+        // entries being migrated are still visible
+        if(hm->old.capacity >= 4096 && hm->old.capacity != reported) {
+            reported = hm->old.capacity;
+            printf("resizing %lu -> %lu, %lu/%lu migrated, get(%d): %d\n",
+                    hm->old.capacity, hm->cur.capacity, hm->migrated,
+                    hm->old.capacity, i / 2, *(int*)hm_get(hm, refi(i / 2)));
+        }
+    }
+
+    size_t missing = 0;
+    for(int i = 0; i < 100000; i++) {
+        int* v = (int*)hm_get(hm, &i);
+        if(!v || *v != i * 2) missing++;
+    }
+    printf("%lu entries, %lu missing\n", hm_length(hm), missing);
+
+    for(int i = 0; i < 100000; i += 3)
+        hm_unset(hm, &i);
+    for(int i = 100000; i < 150000; i++)
+        hm_set(hm, &i, refi(i * 2));
+    long sums[2] = { 0, 0 };
+    hm_traverse(hm, sum_entries, sums);
+    printf("%lu entries, key sum %ld, value sum %ld\n",
+            hm_length(hm), sums[0], sums[1]);
+    printf("get(3): %p, get(4): %d\n",
+            hm_get(hm, refi(3)), *(int*)hm_get(hm, refi(4)));
+    hm_destroy(hm);
+
+    ////////////////////////////////////////////// Reserve
+
+    hm = hm_create(int64_t, char, hashi64, cmpi64);
+    hm_reserve(hm, 1000);
+    printf("capacity %lu\n", hm->cur.capacity);
+    for(int64_t i = 0; i < 1000; i++)
+        hm_set(hm, refi64(i << 32), "x");
+    printf("capacity %lu, %lu entries, resizing: %d\n", hm->cur.capacity,
+            hm_length(hm), hm->old.capacity != 0);
+    hm_destroy(hm);
+}
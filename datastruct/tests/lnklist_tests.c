@@ -1,4 +1,4 @@
-// cflags: exception.c lnklist.c utils.c
+// cflags: exception.c lnklist.c mempool.c utils.c
 
 #include <stdio.h>
 
@@ -61,4 +61,31 @@ int main()
 
     ll_destroy(lli);
     ll_destroy(lli_temp);
+
+    ////////////////////////////////////////////// Pooled
+
+    mempool* pool = ll_pool_create(int);
+    lli = ll_create_pooled(int, pool);
+    lli_temp = ll_create_pooled(int, pool);
+    for(int i = 0; i < 20; i++) ll_append(lli, &i);
+    for(int i = 0; i < 20; i += 3) ll_remove(lli, ll_iter_at(lli, i / 3 * 2));
+    print_all(lli);
+    ll_move_bef(lli_temp, lli, lli_temp->head, lli->head, 5);
+    printf("%lu: ", lli_temp->length); print_all(lli_temp);
+    printf("%lu: ", lli->length); print_all(lli);
+    ll_destroy(lli_temp);
+
+    lli_temp = ll_create_pooled(int, NULL);
+    ll_append(lli_temp, refi(99));
+    examine {
+        ll_move_bef(lli, lli_temp, lli->head, lli_temp->head, 1);
+    } grab(PoolMismatch) {
+        puts("Cannot move nodes across pools.");
+    }
+    for(int i = 0; i < 100000; i++) ll_prepend(lli_temp, &i);
+    printf("%lu\n", lli_temp->length);
+
+    ll_destroy(lli_temp);
+    ll_destroy(lli);
+    mp_destroy(pool);
 }
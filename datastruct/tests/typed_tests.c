@@ -0,0 +1,75 @@
+// cflags: mempool.c exception.c utils.c
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "../vatyped.h"
+#include "../avltyped.h"
+
+VA_DEFINE(va_int64, int64_t, cmp_num)
+AVL_DEFINE(avl_int_int, int, int, cmp_num)
+
+// balanced, and heights consistent with the children
+int check_avl(avl_int_int_node* n)
+{
+    if(!n) return 0;
+    int l = check_avl(n->left), r = check_avl(n->right);
+    if(l < 0 || r < 0 || l - r > 1 || r - l > 1) return -1;
+    if(n->height != (l > r ? l : r) + 1) return -1;
+    return n->height;
+}
+
+int main()
+{
+    va_int64* va = va_int64_create();
+    for(int64_t i = 0; i < 10; i++)
+        va_int64_append(va, (i * 7) % 10 - 5);
+    va_int64_insert(va, 0, 100);
+    va_int64_remove(va, 3);
+    for(size_t i = 0; i < va->length; i++)
+        printf("%ld ", *va_int64_at(va, i));
+    putchar('\n');
+
+    va_int64_sort(va);
+    for(size_t i = 0; i < va->length; i++)
+        printf("%ld ", va->data[i]);
+    printf("\nlower_bound(0): %lu, lower_bound(101): %lu\n",
+            va_int64_lower_bound(va, 0), va_int64_lower_bound(va, 101));
+
+    examine { va_int64_at(va, va->length); }
+    grab(OutOfRange) { printf("OutOfRange\n"); }
+    va_int64_destroy(va);
+
+    va = va_int64_create();
+    uint64_t state = 88172645463325252ULL;
+    for(int i = 0; i < 100000; i++) {
+        state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+        va_int64_append(va, (int64_t)(state % 1000) - 500);
+    }
+    va_int64_sort(va);
+    size_t inversions = 0;
+    for(size_t i = 1; i < va->length; i++)
+        inversions += va->data[i - 1] > va->data[i];
+    printf("%lu sorted, %lu inversions\n", va->length, inversions);
+    va_int64_destroy(va);
+
+    ////////////////////////////////////////////// AVL
+
+    avl_int_int* t = avl_int_int_create();
+    for(int i = 0; i < 1000; i++)
+        avl_int_int_set(t, (i * 37) % 1000, i);
+    avl_int_int_set(t, 37, -1);
+    for(int i = 0; i < 1000; i += 2)
+        avl_int_int_unset(t, i);
+
+    int found = 0;
+    for(int i = 0; i < 1000; i++)
+        found += avl_int_int_get(t, i) != NULL;
+    printf("%lu entries, %d found, height %d, 37 -> %d, 74: %p\n",
+            t->length, found, check_avl(t->root),
+            *avl_int_int_get(t, 37), (void*)avl_int_int_get(t, 74));
+
+    examine { avl_int_int_unset(t, 74); }
+    grab(KeyNotFound) { printf("KeyNotFound\n"); }
+    avl_int_int_destroy(t);
+}
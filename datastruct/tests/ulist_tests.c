@@ -0,0 +1,66 @@
+// cflags: exception.c ulist.c utils.c
+
+#include <stdio.h>
+
+#include "../ulist.h"
+#include "../utils.h"
+#include "../exception.h"
+
+#define print_all(l) { \
+    for(ul_iter i = ul_begin(l); !ul_is_end(i); i = ul_next(i)) \
+        printf("%d ", *(int*)ul_data(l, i)); \
+    putchar('\n'); \
+}
+
+int main()
+{
+    ulist* uli = ul_create(int);
+
+    ul_prepend(uli, refi(4));
+    print_all(uli);
+    ul_append(uli, refi(5));
+    print_all(uli);
+    ul_prepend(uli, refi(6));
+    print_all(uli);
+    ul_insert(uli, 2, refi(8));
+    print_all(uli);
+    ul_prepend(uli, refi(7));
+    print_all(uli);
+    ul_append(uli, refi(3));
+    print_all(uli);
+
+    ul_remove(uli, ul_iter_at(uli, 3));
+    print_all(uli);
+    ul_remove(uli, ul_iter_at(uli, 2));
+    print_all(uli);
+    examine {
+        ul_at(uli, 4);
+    } grab(OutOfRange) {
+        puts("Out of range.");
+    }
+    ul_destroy(uli);
+
+    // stable addresses under prepending, appending and removal
+    uli = ul_create(int);
+    ul_iter mid = ul_append(uli, refi(-1));
+    int* pmid = (int*)ul_data(uli, mid);
+    for(int i = 0; i < 1000; i++) {
+        ul_prepend(uli, &i);
+        ul_append(uli, &i);
+    }
+    for(int i = 0; i < 500; i++)
+        ul_remove(uli, ul_iter_at(uli, i * 2));
+    printf("%lu %d %d\n", ul_length(uli), *pmid,
+            *(int*)ul_data(uli, mid));
+
+    // middle insertions splitting chunks keep the order
+    for(int i = 0; i < 1000; i++)
+        ul_insert(uli, ul_length(uli) / 2, refi(i % 7));
+    int sum = 0, count = 0;
+    for(ul_iter i = ul_begin(uli); !ul_is_end(i); i = ul_next(i), count++)
+        sum += *(int*)ul_data(uli, i);
+    printf("%lu %d %d %d %d\n", ul_length(uli), count, sum,
+            *(int*)ul_at(uli, 1250), *(int*)ul_at(uli, 1251));
+
+    ul_destroy(uli);
+}
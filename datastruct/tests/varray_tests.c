@@ -1,6 +1,7 @@
-// cflags: exception.c varray.c vaheap.c utils.c
+// cflags: exception.c varray.c vasort.c vaheap.c utils.c
 
 #include <stdio.h>
+#include <stdint.h>
 
 #include "../varray.h"
 #include "../exception.h"
@@ -58,6 +59,32 @@ int main()
 
     va_destroy(vai);
 
+    ////////////////////////////////////////////// Bulk
+
+    int seq[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+    vai = va_create(int);
+    va_set_growth(vai, va_growth_golden);
+    va_reserve(vai, 6);
+    printf("capacity: %lu\n", vai->capacity);
+    va_append_n(vai, seq, 8);
+    print_all(vai);
+    va_insert_n(vai, 2, seq + 5, 3);
+    print_all(vai);
+    va_remove_range(vai, 1, 4);
+    print_all(vai);
+    va_remove_range(vai, 4, 100);
+    print_all(vai);
+    // clamped onto the last element, as va_remove does
+    va_remove_range(vai, 4, 1);
+    print_all(vai);
+    examine {
+        va_reserve(vai, SIZE_MAX / 2);
+    } grab(MemoryError) {
+        puts("Too large to reserve.");
+    }
+    va_destroy(vai);
+
     ////////////////////////////////////////////// Heap
 
     vai = va_create(int);
@@ -86,6 +113,44 @@ int main()
 
     va_destroy(vai);
 
+    ////////////////////////////////////////////// Bulk Heap
+
+    int nums[] = { 11, 26, 6, 23, 17, 30, 9, 15, 13, 24, 2, 19 };
+    vai = va_create(int);
+    va_append_n(vai, nums, 6);
+    va_heapify(vai, int_cmp); print_all(vai);
+    va_heap_push_n(vai, int_cmp, nums + 6, 2); print_all(vai);
+    varray* other = va_create(int);
+    va_append_n(other, nums + 8, 4);
+    va_heap_merge(vai, other, int_cmp); print_all(vai);
+    va_heap_remove(vai, int_cmp, 0); print_all(vai);
+    va_heap_sort(vai, (va_cmp)cmpi); print_all(vai);
+    va_destroy(other);
+    va_destroy(vai);
+
+    // the 5 greatest, fed in pieces
+    vai = va_create(int);
+    va_topk(vai, (va_cmp)cmpi, 5, nums, 3);
+    va_topk(vai, (va_cmp)cmpi, 5, nums + 3, 9);
+    printf("least of top 5: %d, ", va_cast(int, vai)[0]);
+    va_heap_sort(vai, (va_cmp)cmpi); print_all(vai);
+    va_destroy(vai);
+
+    ////////////////////////////////////////////// Indexed Heap
+
+    va_iheap* ih = va_iheap_create(10);
+    for(size_t i = 0; i < 10; i++)
+        va_iheap_push(ih, i, (int64_t)(i * 7 % 10) * 10);
+    printf("%d ", va_iheap_push(ih, 9, 5));  // decrease 30 to 5
+    printf("%d ", va_iheap_push(ih, 1, 80)); // 70 stays
+    printf("%d\n", va_iheap_push(ih, 0, 0)); // equal stays
+    for(int64_t key; va_iheap_length(ih); ) {
+        size_t item = va_iheap_pop(ih, &key);
+        printf("%lu:%ld ", item, key);
+    }
+    putchar('\n');
+    va_iheap_destroy(ih);
+
     ////////////////////////////////////////////// Utils
 
     varray* buf = va_create(char);
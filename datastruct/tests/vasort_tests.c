@@ -0,0 +1,124 @@
+// cflags: exception.c varray.c vasort.c vapsort.c thrpool.c utils.c -pthread
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../varray.h"
+#include "../vasort.h"
+#include "../vapsort.h"
+#include "../utils.h"
+
+typedef struct pair_t_ {
+    int key;
+    int seq;
+} pair;
+
+static unsigned rand_state = 12345;
+int next_rand()
+{
+    rand_state = rand_state * 1103515245 + 12345;
+    return (int)(rand_state >> 8) % 1000 - 500;
+}
+
+int int_cmp(void* l, void* r)
+{
+    int a = *(int*)l, b = *(int*)r;
+    return a < b ? -1 : a > b;
+}
+
+int pair_cmp(void* l, void* r)
+{
+    return ((pair*)l)->key - ((pair*)r)->key;
+}
+
+void fill(varray* va, size_t n)
+{
+    va->length = 0;
+    for(size_t i = 0; i < n; i++) {
+        int v = next_rand();
+        va_append(va, &v);
+    }
+}
+
+int check(varray* va, varray* ref)
+{
+    for(size_t i = 0; i < va->length; i++)
+        if(va_cast(int, va)[i] != va_cast(int, ref)[i]) return 0;
+    return 1;
+}
+
+#define run_case(name, n, sort) { \
+    fill(vai, n); \
+    ref->length = 0; \
+    va_append_n(ref, vai->data, vai->length); \
+    qsort(ref->data, ref->length, sizeof(int), cmpi); \
+    sort; \
+    printf("%s %lu: %s\n", name, (size_t)n, check(vai, ref) ? "ok" : "WRONG"); \
+}
+
+int main()
+{
+    varray* vai = va_create(int);
+    varray* ref = va_create(int);
+    size_t sizes[] = { 0, 1, 7, 16, 17, 1000, 100000 };
+
+    for(size_t* n = sizes; n < sizes + 7; n++) {
+        run_case("introsort", *n, va_introsort(vai, int_cmp));
+        run_case("stable", *n, va_sort_stable(vai, int_cmp));
+        run_case("radix", *n, va_radix_sort_i32(vai));
+        run_case("va_sort", *n, va_sort(vai, (va_cmp)cmpi));
+        run_case("parallel", *n, va_sort_parallel(vai, int_cmp, 4));
+    }
+    run_case("parallel", 1000003, va_sort_parallel(vai, int_cmp, 7));
+
+    // sorted, reversed and all-equal inputs are the classic quadratic cases
+    for(size_t i = 0; i < vai->length; i++) va_cast(int, vai)[i] = 7;
+    va_introsort(vai, int_cmp);
+    for(size_t i = 0; i < vai->length; i++) va_cast(int, vai)[i] = -i;
+    va_introsort(vai, int_cmp);
+    va_introsort(vai, int_cmp);
+    ref->length = 0;
+    for(size_t i = vai->length; i > 0; i--) {
+        int v = 1 - (int)i;
+        va_append(ref, &v);
+    }
+    printf("introsort degenerate: %s\n", check(vai, ref) ? "ok" : "WRONG");
+
+    varray* vap = va_create(pair);
+    for(int i = 0; i < 300000; i++) {
+        pair p = { next_rand() % 10, i };
+        va_append(vap, &p);
+    }
+    varray* vap_par = va_create(pair);
+    va_append_n(vap_par, vap->data, vap->length);
+
+    va_sort_stable(vap, pair_cmp);
+    va_sort_parallel(vap_par, pair_cmp, 3);
+    int stable = 1;
+    for(size_t i = 1; i < vap->length; i++) {
+        pair* a = va_cast(pair, vap) + i - 1, *b = a + 1;
+        if(a->key > b->key || (a->key == b->key && a->seq > b->seq))
+            stable = 0;
+    }
+    printf("stable: %s\n", stable ? "ok" : "WRONG");
+    printf("parallel stable: %s\n", memcmp(vap->data, vap_par->data,
+        vap->length * sizeof(pair)) ? "WRONG" : "ok");
+    va_destroy(vap_par);
+
+    varray* val = va_create(int64_t);
+    for(int64_t i = 0; i < 1000; i++) {
+        int64_t v = (i * 7919 % 1000 - 500) * 10000000000LL;
+        va_append(val, &v);
+    }
+    va_sort(val, (va_cmp)cmpi64);
+    int sorted = 1;
+    for(size_t i = 1; i < val->length; i++)
+        if(va_cast(int64_t, val)[i - 1] > va_cast(int64_t, val)[i]) sorted = 0;
+    printf("radix i64: %s\n", sorted ? "ok" : "WRONG");
+
+    va_destroy(val);
+    va_destroy(vap);
+    va_destroy(ref);
+    va_destroy(vai);
+}
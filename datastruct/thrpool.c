@@ -0,0 +1,144 @@
+/*
+ * Copyright(c) 2015, Shihira Fung <fengzhiping@hotmail.com>
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "exception.h"
+#include "thrpool.h"
+
+size_t tp_ncpus()
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (size_t)n : 1;
+}
+
+static void* tp_worker_(void* usr)
+{
+    thrpool* tp = (thrpool*)usr;
+
+    pthread_mutex_lock(&tp->lock);
+    while(1) {
+        while(tp->qhead == tp->queue->length && !tp->stopping)
+            pthread_cond_wait(&tp->wake, &tp->lock);
+        if(tp->qhead == tp->queue->length) break; // stopping and drained
+
+        tp_job job = va_cast(tp_job, tp->queue)[tp->qhead++];
+        if(tp->qhead == tp->queue->length)
+            tp->qhead = tp->queue->length = 0;
+
+        pthread_mutex_unlock(&tp->lock);
+        job.fn(job.arg);
+        pthread_mutex_lock(&tp->lock);
+
+        if(--tp->pending == 0)
+            pthread_cond_broadcast(&tp->idle);
+    }
+    pthread_mutex_unlock(&tp->lock);
+
+    return NULL;
+}
+
+thrpool* tp_create(size_t nthreads)
+{
+    if(!nthreads) nthreads = tp_ncpus();
+
+    // the queue goes first as va_create tosses on its own
+    varray* queue = va_create(tp_job);
+    thrpool* tp = (thrpool*) malloc(sizeof(thrpool));
+    pthread_t* workers = (pthread_t*) malloc(nthreads * sizeof(pthread_t));
+    if(!tp || !workers) {
+        free(workers);
+        free(tp);
+        va_destroy(queue);
+        toss(MemoryError);
+    }
+
+    tp->workers = workers;
+    tp->queue = queue;
+    tp->qhead = 0;
+    tp->pending = 0;
+    tp->stopping = 0;
+    pthread_mutex_init(&tp->lock, NULL);
+    pthread_cond_init(&tp->wake, NULL);
+    pthread_cond_init(&tp->idle, NULL);
+
+    for(tp->nworkers = 0; tp->nworkers < nthreads; tp->nworkers++)
+        if(pthread_create(tp->workers + tp->nworkers, NULL, tp_worker_, tp)) {
+            // stop and join the workers started so far
+            tp_destroy(tp);
+            toss(ThreadError);
+        }
+
+    return tp;
+}
+
+void tp_submit(thrpool* tp, tp_task fn, void* arg)
+{
+    tp_job job = { fn, arg };
+
+    pthread_mutex_lock(&tp->lock);
+    va_append(tp->queue, &job);
+    tp->pending++;
+    pthread_cond_signal(&tp->wake);
+    pthread_mutex_unlock(&tp->lock);
+}
+
+void tp_wait(thrpool* tp)
+{
+    pthread_mutex_lock(&tp->lock);
+    while(tp->pending)
+        pthread_cond_wait(&tp->idle, &tp->lock);
+    pthread_mutex_unlock(&tp->lock);
+}
+
+void tp_destroy(thrpool* tp)
+{
+    pthread_mutex_lock(&tp->lock);
+    tp->stopping = 1;
+    pthread_cond_broadcast(&tp->wake);
+    pthread_mutex_unlock(&tp->lock);
+
+    for(size_t i = 0; i < tp->nworkers; i++)
+        pthread_join(tp->workers[i], NULL);
+
+    pthread_cond_destroy(&tp->idle);
+    pthread_cond_destroy(&tp->wake);
+    pthread_mutex_destroy(&tp->lock);
+    va_destroy(tp->queue);
+    free(tp->workers);
+    free(tp);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Parallel For
+
+typedef struct tp_for_info_t_ {
+    void (*cb) (size_t, void*);
+    void* usr;
+    size_t i;
+} tp_for_info;
+
+static void tp_for_task_(void* arg)
+{
+    tp_for_info* info = (tp_for_info*)arg;
+    info->cb(info->i, info->usr);
+}
+
+void tp_parallel_for(thrpool* tp, size_t n,
+        void (*cb) (size_t, void*), void* usr)
+{
+    tp_for_info* infos = (tp_for_info*) malloc(n * sizeof(tp_for_info));
+    if(n && !infos) toss(MemoryError);
+
+    for(size_t i = 0; i < n; i++) {
+        infos[i].cb = cb;
+        infos[i].usr = usr;
+        infos[i].i = i;
+        tp_submit(tp, tp_for_task_, infos + i);
+    }
+
+    tp_wait(tp);
+    free(infos);
+}
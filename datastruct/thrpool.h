@@ -0,0 +1,50 @@
+/*
+ * Copyright(c) 2015, Shihira Fung <fengzhiping@hotmail.com>
+ */
+
+#ifndef THRPOOL_H_INCLUDED
+#define THRPOOL_H_INCLUDED
+
+#include <stddef.h>
+#include <pthread.h>
+
+#include "varray.h"
+
+/*
+ * A fixed set of worker threads consuming a FIFO of tasks. Tasks must catch
+ * whatever they toss: every thread has its own handlers, and an exception
+ * raised in a worker can't land on those of the thread submitting it.
+ */
+
+typedef void (*tp_task) (void*);
+
+typedef struct tp_job_t_ {
+    tp_task fn;
+    void* arg;
+} tp_job;
+
+typedef struct thrpool_t_ {
+    pthread_t* workers;
+    size_t nworkers;
+    varray/*<tp_job>*/* queue;
+    size_t qhead; // jobs before qhead have been taken
+    size_t pending; // jobs queued or running
+    int stopping;
+    pthread_mutex_t lock;
+    pthread_cond_t wake; // new jobs arrived or the pool is stopping
+    pthread_cond_t idle; // pending dropped to zero
+} thrpool;
+
+// nthreads being 0 means one thread per online processor
+thrpool* tp_create(size_t nthreads);
+void tp_submit(thrpool* tp, tp_task fn, void* arg);
+// block until every submitted task has finished
+void tp_wait(thrpool* tp);
+void tp_destroy(thrpool* tp);
+
+// run cb(i, usr) for every i in [0, n) on the pool and wait for them
+void tp_parallel_for(thrpool* tp, size_t n,
+        void (*cb) (size_t, void*), void* usr);
+size_t tp_ncpus();
+
+#endif // THRPOOL_H_INCLUDED
@@ -0,0 +1,202 @@
+/*
+ * Copyright(c) 2015, Shihira Fung <fengzhiping@hotmail.com>
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "dsstat.h"
+#include "exception.h"
+#include "ulist.h"
+
+#define bit(i) ((uint64_t)1 << (i))
+#define lowest_slot(m) ((unsigned)__builtin_ctzll(m))
+#define highest_slot(m) (UL_CHUNK - 1 - (unsigned)__builtin_clzll(m))
+#define slot_at(c, s, sz) ((c)->data + (s) * (sz))
+
+ulist* ul_create_(size_t szelem)
+{
+    ulist* ul = (ulist*) malloc(sizeof(ulist));
+    if(!ul) toss(MemoryError);
+
+    ul->elem_size = szelem;
+    ul->length = 0;
+    ul->head = ul->tail = NULL;
+
+    return ul;
+}
+
+void ul_destroy(ulist* ul)
+{
+    while(ul->head) {
+        ul_chunk* next = ul->head->next;
+        free(ul->head);
+        ds_stat_free(DS_STAT_ULIST);
+        ul->head = next;
+    }
+
+    free(ul);
+}
+
+size_t ul_length(const ulist* ul)
+{ return ul->length; }
+
+// link a new empty chunk after `prev`, or to the head if `prev` is null
+static ul_chunk* ul_new_chunk_(ulist* ul, ul_chunk* prev)
+{
+    ul_chunk* c = (ul_chunk*) malloc(sizeof(ul_chunk) + UL_CHUNK * ul->elem_size);
+    if(!c) toss(MemoryError);
+    ds_stat_alloc(DS_STAT_ULIST, sizeof(ul_chunk) + UL_CHUNK * ul->elem_size);
+    c->data = (unsigned char*)(c + 1);
+    c->live = 0;
+
+    c->prev = prev;
+    c->next = prev ? prev->next : ul->head;
+    if(c->next) c->next->prev = c;
+    else ul->tail = c;
+    if(prev) prev->next = c;
+    else ul->head = c;
+
+    return c;
+}
+
+static ul_iter ul_fill_(ulist* ul, ul_chunk* c, unsigned slot, void* data)
+{
+    ul_iter i = { c, slot };
+
+    c->live |= bit(slot);
+    if(data) memcpy(slot_at(c, slot, ul->elem_size), data, ul->elem_size);
+    ul->length++;
+
+    return i;
+}
+
+ul_iter ul_prepend(ulist* ul, void* data)
+{
+    ul_chunk* c = ul->head;
+    if(c && !(c->live & 1))
+        return ul_fill_(ul, c, lowest_slot(c->live) - 1, data);
+
+    // later prepends grow downwards in the new chunk
+    return ul_fill_(ul, ul_new_chunk_(ul, NULL), UL_CHUNK - 1, data);
+}
+
+ul_iter ul_append(ulist* ul, void* data)
+{
+    ul_chunk* c = ul->tail;
+    if(c && !(c->live & bit(UL_CHUNK - 1)))
+        return ul_fill_(ul, c, highest_slot(c->live) + 1, data);
+
+    return ul_fill_(ul, ul_new_chunk_(ul, ul->tail), 0, data);
+}
+
+ul_iter ul_insert(ulist* ul, size_t pos, void* data)
+{
+    if(pos == 0) return ul_prepend(ul, data);
+    if(pos >= ul->length) return ul_append(ul, data);
+
+    ul_iter at = ul_iter_at(ul, pos);
+    ul_chunk* c = at.chunk;
+    size_t sz = ul->elem_size;
+
+    if(!~c->live) {
+        // split a full chunk in halves, slots keep their indices
+        ul_chunk* upper = ul_new_chunk_(ul, c);
+        uint64_t mask = ~(uint64_t)0 << (UL_CHUNK / 2);
+        memcpy(slot_at(upper, UL_CHUNK / 2, sz),
+                slot_at(c, UL_CHUNK / 2, sz), UL_CHUNK / 2 * sz);
+        upper->live = mask;
+        c->live = ~mask;
+
+        if(at.slot >= UL_CHUNK / 2) c = upper;
+    }
+
+    // the new element takes over the slot of `at`, shifting the neighbours
+    // towards the nearest hole
+    uint64_t above = ~c->live & (~(uint64_t)0 << at.slot);
+    if(above) {
+        unsigned hole = lowest_slot(above);
+        memmove(slot_at(c, at.slot + 1, sz), slot_at(c, at.slot, sz),
+                (hole - at.slot) * sz);
+        c->live |= bit(hole);
+        return ul_fill_(ul, c, at.slot, data);
+    } else {
+        unsigned hole = highest_slot(~c->live & (bit(at.slot) - 1));
+        memmove(slot_at(c, hole, sz), slot_at(c, hole + 1, sz),
+                (at.slot - 1 - hole) * sz);
+        c->live |= bit(hole);
+        return ul_fill_(ul, c, at.slot - 1, data);
+    }
+}
+
+void ul_remove(ulist* ul, ul_iter i)
+{
+    ul_chunk* c = i.chunk;
+    if(!c || !(c->live & bit(i.slot))) toss(InvalidIterator);
+
+    c->live &= ~bit(i.slot);
+    ul->length--;
+    if(c->live) return;
+
+    if(c->prev) c->prev->next = c->next;
+    else ul->head = c->next;
+    if(c->next) c->next->prev = c->prev;
+    else ul->tail = c->prev;
+    free(c);
+    ds_stat_free(DS_STAT_ULIST);
+}
+
+ul_iter ul_begin(const ulist* ul)
+{
+    ul_iter i = { ul->head, 0 };
+    if(i.chunk) i.slot = lowest_slot(i.chunk->live);
+    return i;
+}
+
+ul_iter ul_next(ul_iter i)
+{
+    uint64_t rest = i.slot + 1 < UL_CHUNK ?
+        i.chunk->live & (~(uint64_t)0 << (i.slot + 1)) : 0;
+
+    if(rest) {
+        i.slot = lowest_slot(rest);
+    } else {
+        i.chunk = i.chunk->next;
+        if(i.chunk) i.slot = lowest_slot(i.chunk->live);
+    }
+
+    return i;
+}
+
+ul_iter ul_iter_at(const ulist* ul, size_t pos)
+{
+    ul_iter i = { ul->head, 0 };
+
+    for(; i.chunk; i.chunk = i.chunk->next) {
+        size_t count = __builtin_popcountll(i.chunk->live);
+        if(pos < count) break;
+        pos -= count;
+    }
+    if(!i.chunk) return i;
+
+    uint64_t m = i.chunk->live;
+    for(; pos > 0; pos--) m &= m - 1; // drop the lowest pos slots
+    i.slot = lowest_slot(m);
+
+    return i;
+}
+
+void* ul_at(ulist* ul, size_t pos)
+{
+    ul_iter i = ul_iter_at(ul, pos);
+    if(ul_is_end(i)) toss(OutOfRange);
+    return ul_data(ul, i);
+}
+
+ds_error ul_try_at(ulist* ul, size_t pos, void** elem)
+{
+    ul_iter i = ul_iter_at(ul, pos);
+    if(ul_is_end(i)) return DS_OUT_OF_RANGE;
+    *elem = ul_data(ul, i);
+    return DS_OK;
+}
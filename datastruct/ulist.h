@@ -0,0 +1,74 @@
+/*
+ * Copyright(c) 2015, Shihira Fung <fengzhiping@hotmail.com>
+ */
+
+#ifndef ULIST_H_INCLUDED
+#define ULIST_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "exception.h"
+
+/*
+ * ulist is an unrolled linked list: every chunk holds UL_CHUNK slots
+ * contiguously, and a bit mask telling which slots are occupied. Positional
+ * access skips whole chunks by their population counts, and traversal touches
+ * one cache-friendly block per UL_CHUNK elements.
+ *
+ * Like lnklist, ulist never moves an element in order to prepend, append or
+ * remove, so pointers to elements and iterators stay valid across those.
+ * Removal leaves a hole and a chunk is released once it's empty. The exception
+ * is ul_insert into the middle of the list: it shifts elements of the target
+ * chunk towards a hole, and if the chunk is full it first moves the upper half
+ * of the chunk into a newly allocated one. Either way pointers and iterators
+ * to the moved elements become invalid.
+ *
+ * Traverse a list using a loop like:
+ *
+ *     for(ul_iter i = ul_begin(l); !ul_is_end(i); i = ul_next(i)) {
+ *         // ... ul_data(l, i)
+ *     }
+ */
+
+#define UL_CHUNK 64
+
+typedef struct ul_chunk_t_ {
+    struct ul_chunk_t_* next;
+    struct ul_chunk_t_* prev;
+    uint64_t live; // bit i is set if slot i holds an element
+    unsigned char* data;
+} ul_chunk;
+
+typedef struct ul_iter_t_ {
+    ul_chunk* chunk; // NULL for past-the-end
+    unsigned slot;
+} ul_iter;
+
+typedef struct ulist_t_ {
+    size_t elem_size;
+    size_t length;
+    ul_chunk* head;
+    ul_chunk* tail;
+} ulist;
+
+ulist* ul_create_(size_t szelem);
+void ul_destroy(ulist* ul);
+size_t ul_length(const ulist* ul);
+
+ul_iter ul_insert(ulist* ul, size_t pos, void* data);
+ul_iter ul_prepend(ulist* ul, void* data);
+ul_iter ul_append(ulist* ul, void* data);
+void ul_remove(ulist* ul, ul_iter i);
+
+ul_iter ul_begin(const ulist* ul);
+ul_iter ul_next(ul_iter i);
+ul_iter ul_iter_at(const ulist* ul, size_t pos);
+void* ul_at(ulist* ul, size_t pos);
+ds_error ul_try_at(ulist* ul, size_t pos, void** elem);
+
+#define ul_create(type) ul_create_(sizeof(type))
+#define ul_is_end(i) (!(i).chunk)
+#define ul_data(ul, i) ((void*)((i).chunk->data + (i).slot * (ul)->elem_size))
+
+#endif // ULIST_H_INCLUDED
@@ -9,7 +9,8 @@
 int cmpi(void const * a, void const * b)
 {
     int l = *(int const *)a, r = *(int const *)b;
-    return l - r;
+    // l - r would overflow on keys far apart
+    return (l > r) - (l < r);
 }
 
 int cmps(void const * a, void const * b)
@@ -22,7 +23,42 @@ int cmps(void const * a, void const * b)
 int cmpi64(void const * a, void const * b)
 {
     int64_t l = *(int64_t const *)a, r = *(int64_t const *)b;
-    return l - r > 0 ? 1 : l - r < 0 ? -1 : 0;
+    return (l > r) - (l < r);
+}
+
+// the finalizer of MurmurHash3
+static uint64_t mix64(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+uint64_t hashi(void const * a)
+{ return mix64((uint32_t)*(int32_t const *)a); }
+
+uint64_t hashi64(void const * a)
+{ return mix64((uint64_t)*(int64_t const *)a); }
+
+uint64_t hashs(void const * a)
+{
+    char const * s = *(char const * const *)a;
+    return hash_bytes(s, strlen(s));
+}
+
+// FNV-1a, finished by mix64 for the high bits
+uint64_t hash_bytes(void const * data, size_t len)
+{
+    unsigned char const * p = (unsigned char const *)data;
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for(size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    return mix64(h);
 }
 
 #define DEFREF(name, type) type* name(type v) { \
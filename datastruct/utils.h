@@ -6,6 +6,7 @@
 #define UTILS_H_INCLUDED
 
 #include <stdint.h>
+#include <stddef.h>
 
 ////////////////////////////////////////////////////////////////////////////////
 // comparators
@@ -13,6 +14,20 @@ typedef int (*comparator) (void const *, void const *);
 int cmpi(void const * a, void const * b);
 int cmps(void const * a, void const * b);
 int cmpi64(void const * a, void const * b);
+// compares numbers by value rather than by address, for typed containers
+#define cmp_num(a, b) (((a) > (b)) - ((a) < (b)))
+
+////////////////////////////////////////////////////////////////////////////////
+// hash functions, scattering every bit of input over the 64-bit result
+typedef uint64_t (*hasher) (void const *);
+uint64_t hashi(void const * a);
+uint64_t hashs(void const * a);
+uint64_t hashi64(void const * a);
+uint64_t hash_bytes(void const * data, size_t len);
+
+////////////////////////////////////////////////////////////////////////////////
+// hint the cache to fetch what p points to, which is read soon
+#define ds_prefetch(p) __builtin_prefetch(p)
 
 ////////////////////////////////////////////////////////////////////////////////
 // reference generators
@@ -2,7 +2,14 @@
  * Copyright(c) 2015, Shihira Fung <fengzhiping@hotmail.com>
  */
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "vaheap.h"
+#include "dsstat.h"
+#include "exception.h"
+
+#define heap_cmp(cmp, a, b) ds_stat_cmp(DS_STAT_VAHEAP, cmp, a, b)
 
 void va_heap_insert_generic(varray* va, va_cmp cmp,
         va_swp swp, void* data)
@@ -10,9 +17,10 @@ void va_heap_insert_generic(varray* va, va_cmp cmp,
     va_append(va, data);
 
     int i = va->length - 1, p = va_heap_parent(i);
-    while(i > 0 && cmp(va_at(va, p), va_at(va, i)) < 0) {
+    while(i > 0 && heap_cmp(cmp, va_at(va, p), va_at(va, i)) < 0) {
         // Float up i, until it's not greater than its parent
         swp(va, i, p);
+        ds_stat_inc(DS_STAT_VAHEAP, DS_STAT_SIFTS);
         i = p;
         p = va_heap_parent(i);
     }
@@ -35,14 +43,231 @@ void va_heap_remove_generic(varray* va, va_cmp cmp,
         for(size_t* ifam = family; ifam < family + 3; ifam++) {
             // Doesn't have a child? Congratulations!
             if(!va_exists(va, *ifam)) continue;
-            if(cmp(va_at(va, max), va_at(va, *ifam)) < 0)
+            if(heap_cmp(cmp, va_at(va, max), va_at(va, *ifam)) < 0)
                 max = *ifam;
         }
 
         if(max == i) break;
         swp(va, i, max);
+        ds_stat_inc(DS_STAT_VAHEAP, DS_STAT_SIFTS);
 
         i = max;
     }
+
+    // The tail moved into i may instead be greater than i's parent
+    while(i > 0 && i < va->length &&
+            heap_cmp(cmp, va_at(va, va_heap_parent(i)), va_at(va, i)) < 0) {
+        swp(va, i, va_heap_parent(i));
+        ds_stat_inc(DS_STAT_VAHEAP, DS_STAT_SIFTS);
+        i = va_heap_parent(i);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Bulk Operations
+
+#define elem(base, i, sz) ((base) + (i) * (sz))
+// the order of the heap, reversed for va_topk
+#define heap_less(cmp, rev, a, b) \
+    ((rev) ? heap_cmp(cmp, b, a) < 0 : heap_cmp(cmp, a, b) < 0)
+
+// move the element at i down to where its children are not greater
+static void va_heap_sift_down_(unsigned char* base, size_t i, size_t len,
+        size_t sz, va_cmp cmp, int rev)
+{
+    unsigned char hole[sz];
+    memcpy(hole, elem(base, i, sz), sz);
+
+    for(size_t c; (c = va_heap_lchild(i)) < len; i = c) {
+        if(c + 1 < len && heap_less(cmp, rev,
+                    elem(base, c, sz), elem(base, c + 1, sz)))
+            c++;
+        if(!heap_less(cmp, rev, hole, elem(base, c, sz))) break;
+        memcpy(elem(base, i, sz), elem(base, c, sz), sz);
+        ds_stat_inc(DS_STAT_VAHEAP, DS_STAT_SIFTS);
+    }
+    memcpy(elem(base, i, sz), hole, sz);
+}
+
+static void va_heap_sift_up_(unsigned char* base, size_t i,
+        size_t sz, va_cmp cmp, int rev)
+{
+    unsigned char hole[sz];
+    memcpy(hole, elem(base, i, sz), sz);
+
+    for(size_t p; i > 0 && heap_less(cmp, rev,
+                elem(base, p = va_heap_parent(i), sz), hole); i = p) {
+        memcpy(elem(base, i, sz), elem(base, p, sz), sz);
+        ds_stat_inc(DS_STAT_VAHEAP, DS_STAT_SIFTS);
+    }
+    memcpy(elem(base, i, sz), hole, sz);
+}
+
+static void va_heapify_(unsigned char* base, size_t len,
+        size_t sz, va_cmp cmp, int rev)
+{
+    for(size_t i = len / 2; i > 0; i--)
+        va_heap_sift_down_(base, i - 1, len, sz, cmp, rev);
+}
+
+void va_heapify(varray* va, va_cmp cmp)
+{ va_heapify_(va->data, va->length, va->elem_size, cmp, 0); }
+
+void va_heap_push_n(varray* va, va_cmp cmp, void* data, size_t count)
+{
+    size_t len = va->length;
+    va_append_n(va, data, count);
+
+    // sifting up costs about count * log(n), heapifying about n
+    size_t log_n = 1;
+    for(size_t n = va->length; n > 1; n /= 2) log_n++;
+    if(count * log_n > va->length) {
+        va_heapify(va, cmp);
+        return;
+    }
+
+    for(size_t i = len; i < va->length; i++)
+        va_heap_sift_up_(va->data, i, va->elem_size, cmp, 0);
+}
+
+void va_heap_merge(varray* va, varray* src, va_cmp cmp)
+{
+    if(va->elem_size != src->elem_size) toss(InvalidElemSize);
+    va_heap_push_n(va, cmp, src->data, src->length);
 }
 
+void va_heap_sort(varray* va, va_cmp cmp)
+{
+    unsigned char* base = va->data;
+    size_t sz = va->elem_size;
+    unsigned char tmp[sz];
+
+    va_heapify_(base, va->length, sz, cmp, 0);
+    // move the greatest behind the shrinking heap, one after another
+    for(size_t len = va->length; len > 1; len--) {
+        memcpy(tmp, base, sz);
+        memcpy(base, elem(base, len - 1, sz), sz);
+        memcpy(elem(base, len - 1, sz), tmp, sz);
+        va_heap_sift_down_(base, 0, len - 1, sz, cmp, 0);
+    }
+}
+
+void va_topk(varray* va, va_cmp cmp, size_t k, void* data, size_t count)
+{
+    size_t sz = va->elem_size;
+    unsigned char* in = (unsigned char*)data;
+
+    // fill up to k first, then the heap is built only once
+    size_t fill = va->length < k ? k - va->length : 0;
+    if(fill > count) fill = count;
+    if(fill) {
+        va_append_n(va, in, fill);
+        va_heapify_(va->data, va->length, sz, cmp, 1);
+    }
+
+    for(size_t i = fill; i < count; i++) {
+        unsigned char* e = elem(in, i, sz);
+        if(!va->length || heap_cmp(cmp, e, va->data) <= 0) continue;
+        memcpy(va->data, e, sz);
+        va_heap_sift_down_(va->data, 0, va->length, sz, cmp, 1);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Indexed Heap
+
+#define iheap_parent(i) (((i) - 1) / VA_IHEAP_ARITY)
+#define iheap_child(i) ((i) * VA_IHEAP_ARITY + 1)
+
+va_iheap* va_iheap_create(size_t nitems)
+{
+    va_iheap* h = (va_iheap*)malloc(sizeof(va_iheap));
+    if(!h) toss(MemoryError);
+    h->pos = (size_t*)malloc((nitems ? nitems : 1) * sizeof(size_t));
+    if(!h->pos) toss(MemoryError);
+
+    for(size_t i = 0; i < nitems; i++)
+        h->pos[i] = VA_IHEAP_NONE;
+    h->nitems = nitems;
+    h->nodes = va_create(va_iheap_node);
+
+    return h;
+}
+
+void va_iheap_destroy(va_iheap* h)
+{
+    va_destroy(h->nodes);
+    free(h->pos);
+    free(h);
+}
+
+// move node up from i until its parent is not greater, as a hole
+static void va_iheap_sift_up_(va_iheap* h, size_t i, va_iheap_node node)
+{
+    va_iheap_node* nodes = va_cast(va_iheap_node, h->nodes);
+
+    while(i > 0 && nodes[iheap_parent(i)].key > node.key) {
+        nodes[i] = nodes[iheap_parent(i)];
+        h->pos[nodes[i].item] = i;
+        ds_stat_inc(DS_STAT_VAHEAP, DS_STAT_SIFTS);
+        i = iheap_parent(i);
+    }
+
+    nodes[i] = node;
+    h->pos[node.item] = i;
+}
+
+static void va_iheap_sift_down_(va_iheap* h, size_t i, va_iheap_node node)
+{
+    va_iheap_node* nodes = va_cast(va_iheap_node, h->nodes);
+    size_t len = h->nodes->length;
+
+    while(iheap_child(i) < len) {
+        size_t first = iheap_child(i), least = first;
+        size_t last = first + VA_IHEAP_ARITY < len ?
+            first + VA_IHEAP_ARITY : len;
+        for(size_t c = first + 1; c < last; c++)
+            if(nodes[c].key < nodes[least].key) least = c;
+
+        if(nodes[least].key >= node.key) break;
+        nodes[i] = nodes[least];
+        h->pos[nodes[i].item] = i;
+        ds_stat_inc(DS_STAT_VAHEAP, DS_STAT_SIFTS);
+        i = least;
+    }
+
+    nodes[i] = node;
+    h->pos[node.item] = i;
+}
+
+int va_iheap_push(va_iheap* h, size_t item, int64_t key)
+{
+    if(item >= h->nitems) toss(OutOfRange);
+
+    va_iheap_node node = { key, item };
+    size_t i = h->pos[item];
+
+    if(i == VA_IHEAP_NONE) {
+        va_append_n(h->nodes, NULL, 1);
+        i = h->nodes->length - 1;
+    } else if(va_cast(va_iheap_node, h->nodes)[i].key <= key)
+        return 0;
+
+    va_iheap_sift_up_(h, i, node);
+    return 1;
+}
+
+size_t va_iheap_pop(va_iheap* h, int64_t* key)
+{
+    if(!h->nodes->length) toss(Underflow);
+
+    va_iheap_node* nodes = va_cast(va_iheap_node, h->nodes);
+    va_iheap_node top = nodes[0];
+    va_iheap_node tail = nodes[--h->nodes->length];
+
+    h->pos[top.item] = VA_IHEAP_NONE;
+    if(h->nodes->length) va_iheap_sift_down_(h, 0, tail);
+    if(key) *key = top.key;
+
+    return top.item;
+}
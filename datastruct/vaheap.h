@@ -8,12 +8,12 @@
 // vaheap is a heap based on variable-length array(O(1) for addressing element)
 // Maximum heap by default. You can configure on this by modifying cmp.
 
+#include <stdint.h>
+
 #include "varray.h"
 
 typedef void (*va_swp) (varray*, size_t, size_t);
 
-#define va_heap_sort(va, cmp) va_sort(va, cmp)
-
 #define va_heap_parent(i) (((i) - 1)/2)
 #define va_heap_lchild(i) ((i) * 2 + 1)
 #define va_heap_rchild(i) ((i) * 2 + 2)
@@ -28,5 +28,62 @@ void va_heap_remove_generic(varray* va, va_cmp cmp,
 #define va_heap_remove(va, cmp, i) \
     va_heap_remove_generic(va, cmp, va_swap, i);
 
+/*
+ * Bulk operations move elements through a hole instead of calling a va_swp,
+ * so they suit plain heaps only, not those tracking positions by swp.
+ *
+ * va_heapify arranges any array into a heap in O(n), sifting down from the
+ * last parent to the root. va_heap_push_n appends count elements and either
+ * sifts them up one by one or heapifies the whole array, whichever is less
+ * work. va_heap_merge pushes all elements of src into va.
+ */
+void va_heapify(varray* va, va_cmp cmp);
+void va_heap_push_n(varray* va, va_cmp cmp, void* data, size_t count);
+void va_heap_merge(varray* va, varray* src, va_cmp cmp);
+// sort ascending in place and in O(n log n), whatever order va is in
+void va_heap_sort(varray* va, va_cmp cmp);
+/*
+ * Stream count elements through va, which keeps the k greatest elements seen
+ * so far by cmp. va is a heap of the reverse order, so the least of them is
+ * at va[0] and every new element is compared with it alone, making it
+ * O(count log k) in total. Call it again to feed more, and va_heap_sort va to
+ * get the result in order.
+ */
+void va_topk(varray* va, va_cmp cmp, size_t k, void* data, size_t count);
+
+/*
+ * va_iheap is an indexed minimum heap over items numbered from 0 to nitems-1,
+ * each with an int64 key. Knowing where every item is in the heap, it can
+ * decrease the key of an item in place, without the removal and reinsertion
+ * needed by va_heap_*_generic. Nodes have VA_IHEAP_ARITY children, which makes
+ * the heap shallower and sifting down touches fewer cache lines.
+ */
+
+#define VA_IHEAP_ARITY 4
+#define VA_IHEAP_NONE SIZE_MAX
+
+typedef struct va_iheap_node_t_ {
+    int64_t key;
+    size_t item;
+} va_iheap_node;
+
+typedef struct va_iheap_t_ {
+    varray/*<va_iheap_node>*/* nodes;
+    size_t* pos; // position of every item in nodes, VA_IHEAP_NONE if absent
+    size_t nitems;
+} va_iheap;
+
+va_iheap* va_iheap_create(size_t nitems);
+void va_iheap_destroy(va_iheap* h);
+// insert the item, or lower its key if it's in the heap with a greater key.
+// returns whether the heap has changed
+int va_iheap_push(va_iheap* h, size_t item, int64_t key);
+// remove the item of the least key, and store the key if not null
+size_t va_iheap_pop(va_iheap* h, int64_t* key);
+
+#define va_iheap_length(h) ((h)->nodes->length)
+#define va_iheap_contains(h, i) ((h)->pos[i] != VA_IHEAP_NONE)
+#define va_iheap_top(h) (va_cast(va_iheap_node, (h)->nodes)[0])
+
 #endif // VAHEAP_H_INCLUDED
 
@@ -0,0 +1,173 @@
+/*
+ * Copyright(c) 2015, Shihira Fung <fengzhiping@hotmail.com>
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "dsstat.h"
+#include "exception.h"
+#include "thrpool.h"
+#include "vasort.h"
+#include "vapsort.h"
+
+// threads are not worth it on arrays shorter than this
+#define PARALLEL_THRESHOLD 65536
+#define SAMPLES_PER_CHUNK 64
+
+#define elem(base, i, sz) ((unsigned char*)(base) + (i) * (sz))
+#define sort_cmp(cmp, a, b) ds_stat_cmp(DS_STAT_VARRAY, cmp, a, b)
+
+/*
+ * The buffer is cut into one chunk per thread and each chunk is sorted stably.
+ * Samples drawn from the sorted chunks give nparts-1 splitters, and lower bound
+ * of every splitter in every chunk cuts the chunks into nparts groups of
+ * segments. Groups occupy disjoint ranges of the output, so they are k-way
+ * merged concurrently. Equal keys always fall into the same group, and merging
+ * prefers the lower chunk on ties, thus the whole sort is stable.
+ */
+
+typedef struct va_psort_info_t_ {
+    unsigned char* src;
+    unsigned char* dst;
+    size_t szelem;
+    va_cmp cmp;
+    size_t nchunks;
+    size_t nparts;
+    size_t* bounds; // chunk c spans [bounds[c], bounds[c + 1])
+    size_t* splits; // group j of chunk c starts at splits[c * (nparts+1) + j]
+} va_psort_info;
+
+#define psort_split(info, c, j) ((info)->splits[(c) * ((info)->nparts + 1) + (j)])
+
+static void va_psort_chunk_(size_t c, void* usr)
+{
+    va_psort_info* info = (va_psort_info*)usr;
+    va_sort_stable_(elem(info->src, info->bounds[c], info->szelem),
+            info->bounds[c + 1] - info->bounds[c], info->szelem, info->cmp);
+}
+
+// heads of chunks are ordered by key, and then by chunk index
+static inline int va_psort_less_(va_psort_info* info,
+        size_t* pos, size_t a, size_t b)
+{
+    int cmp = sort_cmp(info->cmp, elem(info->src, pos[a], info->szelem),
+            elem(info->src, pos[b], info->szelem));
+    return cmp < 0 || (cmp == 0 && a < b);
+}
+
+static void va_psort_merge_(size_t j, void* usr)
+{
+    va_psort_info* info = (va_psort_info*)usr;
+    size_t k = info->nchunks, sz = info->szelem;
+
+    size_t* pos = (size_t*) malloc(k * 3 * sizeof(size_t));
+    if(!pos) toss(MemoryError);
+    size_t* end = pos + k, * heap = pos + 2 * k;
+    size_t nheap = 0, out = 0;
+
+    for(size_t c = 0; c < k; c++) {
+        pos[c] = psort_split(info, c, j);
+        end[c] = psort_split(info, c, j + 1);
+        out += pos[c] - info->bounds[c];
+        if(pos[c] == end[c]) continue;
+
+        // float up new chunk in the min-heap
+        size_t i = nheap++;
+        for(; i > 0 && va_psort_less_(info, pos, c, heap[(i - 1) / 2]);
+                i = (i - 1) / 2)
+            heap[i] = heap[(i - 1) / 2];
+        heap[i] = c;
+    }
+
+    unsigned char* dst = elem(info->dst, out, sz);
+    while(nheap) {
+        size_t c = heap[0];
+        memcpy(dst, elem(info->src, pos[c], sz), sz);
+        dst += sz;
+
+        if(++pos[c] == end[c]) c = heap[--nheap];
+        // sink c down from the root
+        size_t i = 0;
+        for(size_t ch; (ch = i * 2 + 1) < nheap; i = ch) {
+            if(ch + 1 < nheap && va_psort_less_(info, pos, heap[ch + 1], heap[ch]))
+                ch++;
+            if(!va_psort_less_(info, pos, heap[ch], c)) break;
+            heap[i] = heap[ch];
+        }
+        if(nheap) heap[i] = c;
+    }
+
+    free(pos);
+}
+
+static size_t va_lower_bound_(unsigned char* base, size_t lo, size_t hi,
+        size_t sz, va_cmp cmp, void* key)
+{
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if(sort_cmp(cmp, elem(base, mid, sz), key) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+void va_sort_parallel(varray* va, va_cmp cmp, size_t nthreads)
+{
+    size_t len = va->length, sz = va->elem_size;
+    if(!nthreads) nthreads = tp_ncpus();
+    if(nthreads > len / (PARALLEL_THRESHOLD / 4))
+        nthreads = len / (PARALLEL_THRESHOLD / 4);
+    if(len < PARALLEL_THRESHOLD || nthreads < 2) {
+        va_sort_stable(va, cmp);
+        return;
+    }
+
+    va_psort_info info;
+    info.src = va->data;
+    info.szelem = sz;
+    info.cmp = cmp;
+    info.nchunks = info.nparts = nthreads;
+    info.dst = (unsigned char*) malloc(va->capacity * sz);
+    info.bounds = (size_t*) malloc((nthreads + 1) * sizeof(size_t));
+    info.splits = (size_t*) malloc(nthreads * (nthreads + 1) * sizeof(size_t));
+    size_t nsamples = nthreads * SAMPLES_PER_CHUNK;
+    unsigned char* samples = (unsigned char*) malloc(nsamples * sz);
+    if(!info.dst || !info.bounds || !info.splits || !samples)
+        toss(MemoryError);
+
+    for(size_t c = 0; c <= nthreads; c++)
+        info.bounds[c] = len * c / nthreads;
+
+    thrpool* tp = tp_create(nthreads);
+    tp_parallel_for(tp, info.nchunks, va_psort_chunk_, &info);
+
+    for(size_t c = 0; c < info.nchunks; c++) {
+        size_t clen = info.bounds[c + 1] - info.bounds[c];
+        for(size_t s = 0; s < SAMPLES_PER_CHUNK; s++)
+            memcpy(elem(samples, c * SAMPLES_PER_CHUNK + s, sz),
+                elem(info.src, info.bounds[c] +
+                    clen * s / SAMPLES_PER_CHUNK, sz), sz);
+    }
+    va_sort_stable_(samples, nsamples, sz, cmp);
+
+    for(size_t c = 0; c < info.nchunks; c++) {
+        psort_split(&info, c, 0) = info.bounds[c];
+        psort_split(&info, c, info.nparts) = info.bounds[c + 1];
+        for(size_t j = 1; j < info.nparts; j++)
+            psort_split(&info, c, j) = va_lower_bound_(info.src,
+                psort_split(&info, c, j - 1), info.bounds[c + 1], sz, cmp,
+                elem(samples, nsamples * j / info.nparts, sz));
+    }
+
+    tp_parallel_for(tp, info.nparts, va_psort_merge_, &info);
+    tp_destroy(tp);
+
+    // merged result has the same capacity, take it over
+    free(va->data);
+    va->data = info.dst;
+
+    free(samples);
+    free(info.splits);
+    free(info.bounds);
+}
@@ -0,0 +1,20 @@
+/*
+ * Copyright(c) 2015, Shihira Fung <fengzhiping@hotmail.com>
+ */
+
+#ifndef VAPSORT_H_INCLUDED
+#define VAPSORT_H_INCLUDED
+
+// vapsort sorts varrays on a thread pool. It's kept apart from vasort, so that
+// only its users need to link thrpool.c and pthread.
+
+#include "varray.h"
+
+/*
+ * Sort chunks on a pool of nthreads (0 for all processors) and merge them in
+ * parallel. The sort is stable, thus equal to va_sort_stable, and differs from
+ * va_sort only in the order among equal keys.
+ */
+void va_sort_parallel(varray* va, va_cmp cmp, size_t nthreads);
+
+#endif // VAPSORT_H_INCLUDED
@@ -5,8 +5,10 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <stdarg.h>
 
+#include "dsstat.h"
 #include "exception.h"
 #include "varray.h"
 
@@ -18,8 +20,11 @@ varray* va_create_(size_t szelem)
     new_va->length = 0;
     new_va->capacity = INITIAL_ALLOC_SIZE;
     new_va->elem_size = szelem;
+    new_va->growth = va_growth_double;
     new_va->data = (unsigned char*) malloc(INITIAL_ALLOC_SIZE * szelem);
     if(!new_va->data) toss(MemoryError);
+    ds_stat_alloc(DS_STAT_VARRAY, sizeof(varray));
+    ds_stat_alloc(DS_STAT_VARRAY, INITIAL_ALLOC_SIZE * szelem);
 
     return new_va;
 }
@@ -28,46 +33,108 @@ void va_destroy(varray* va)
 {
     if(va->data) free(va->data);
     free(va);
+    ds_stat_add(DS_STAT_VARRAY, DS_STAT_FREES, 2);
 }
 
 size_t va_length(const varray* va)
 { return va->length; }
 
-void va_insert(varray* va, size_t pos, void* data)
+size_t va_growth_double(size_t capacity, size_t required)
 {
-    if(pos > va->length) pos = va->length;
-    if(va->length >= va->capacity) {
-        va->capacity *= 2;
-        va->data = (unsigned char*)
-            realloc(va->data, va->capacity * va->elem_size);
-        if(!va->data) toss(MemoryError);
+    if(!capacity) capacity = INITIAL_ALLOC_SIZE;
+    while(capacity < required) {
+        if(capacity > SIZE_MAX / 2) return SIZE_MAX;
+        capacity *= 2;
     }
+    return capacity;
+}
+
+size_t va_growth_golden(size_t capacity, size_t required)
+{
+    // roughly 1.5x, which leaves freed blocks reusable by later reallocations
+    while(capacity < required) {
+        size_t step = capacity / 2 + 1;
+        if(step > SIZE_MAX - capacity) return SIZE_MAX;
+        capacity += step;
+    }
+    return capacity;
+}
+
+size_t va_growth_exact(size_t capacity, size_t required)
+{ (void)capacity; return required; }
+
+void va_set_growth(varray* va, va_growth growth)
+{ va->growth = growth ? growth : va_growth_double; }
+
+void va_reserve(varray* va, size_t capacity)
+{
+    if(capacity <= va->capacity) return;
+    if(capacity > SIZE_MAX / va->elem_size) toss(MemoryError);
+
+    unsigned char* new_data = (unsigned char*)
+        realloc(va->data, capacity * va->elem_size);
+    if(!new_data) toss(MemoryError);
+    ds_stat_realloc(DS_STAT_VARRAY, capacity * va->elem_size);
+
+    va->data = new_data;
+    va->capacity = capacity;
+}
+
+static void va_grow_(varray* va, size_t required)
+{
+    if(required <= va->capacity) return;
+
+    // policies saturate at SIZE_MAX, stop where the byte size would overflow
+    size_t limit = SIZE_MAX / va->elem_size;
+    if(required > limit) toss(MemoryError);
 
-    // NOTE: i has to be general integer instead of unsigned int here
-    for(int i = va->length * va->elem_size - 1;
-            i >= (int)(pos * va->elem_size); i--)
-        va->data[i + va->elem_size] = va->data[i];
+    size_t capacity = va->growth(va->capacity, required);
+    if(capacity < required) capacity = required;
+    va_reserve(va, capacity > limit ? limit : capacity);
+}
+
+void va_insert_n(varray* va, size_t pos, void* data, size_t count)
+{
+    if(pos > va->length) pos = va->length;
+    if(!count) return;
+    if(count > SIZE_MAX - va->length) toss(MemoryError);
+    va_grow_(va, va->length + count);
+
+    unsigned char* at = va->data + pos * va->elem_size;
+    memmove(at + count * va->elem_size, at,
+            (va->length - pos) * va->elem_size);
 
-    if(data)
-        memcpy(va->data + pos * va->elem_size, data, va->elem_size);
-    va->length++;
+    if(data) memcpy(at, data, count * va->elem_size);
+    va->length += count;
 }
 
+void va_append_n(varray* va, void* data, size_t count)
+{ va_insert_n(va, va->length, data, count); }
+
+void va_insert(varray* va, size_t pos, void* data)
+{ va_insert_n(va, pos, data, 1); }
+
 void va_prepend(varray* va, void* data)
-{ va_insert(va, 0, data); }
+{ va_insert_n(va, 0, data, 1); }
 
 void va_append(varray* va, void* data)
-{ va_insert(va, ~0UL, data); }
+{ va_insert_n(va, va->length, data, 1); }
 
-void va_remove(varray* va, size_t pos)
+void va_remove_range(varray* va, size_t pos, size_t count)
 {
     if(!va->length) toss(Underflow);
-
     if(pos >= va->length) pos = va->length - 1;
-    for(size_t i = pos * va->elem_size;
-            i < (va->length - 1) * va->elem_size; i++)
-        va->data[i] = va->data[i + va->elem_size];
-    va->length--;
+
+    if(count > va->length - pos) count = va->length - pos;
+    unsigned char* at = va->data + pos * va->elem_size;
+    memmove(at, at + count * va->elem_size,
+            (va->length - pos - count) * va->elem_size);
+    va->length -= count;
+}
+
+void va_remove(varray* va, size_t pos)
+{
+    va_remove_range(va, pos, 1);
 }
 
 void* va_at(varray* va, size_t pos)
@@ -76,46 +143,19 @@ void* va_at(varray* va, size_t pos)
     return va->data + pos * va->elem_size;
 }
 
-#define swap(type, a, b) \
-    { type t = a; a = b; b = t; }
-
-static void va_quick_sort_(void* array[], size_t len,
-        int (*cmp) (void* l, void* r))
+ds_error va_try_at(varray* va, size_t pos, void** elem)
 {
-    if(len <= 1) return;
-    void* pivot = array[0];
-    int i = 1, j = len - 1;
-    while(1) {
-        for(; i <= j; i++)
-            if(cmp(array[i], pivot)  > 0) break;
-        for(; i <= j; j--)
-            if(cmp(array[j], pivot) <= 0) break;
-
-        if(i > j) break;
-
-        swap(void*, array[i], array[j]);
-    }
-    swap(void*, array[0], array[j]);
-    va_quick_sort_(array, j, cmp);
-    va_quick_sort_(array + i, len - i, cmp);
+    if(pos >= va->length) return DS_OUT_OF_RANGE;
+    *elem = va->data + pos * va->elem_size;
+    return DS_OK;
 }
 
-void va_sort(varray* va, va_cmp cmp)
+ds_error va_try_remove(varray* va, size_t pos)
 {
-    void** idx = (void**) malloc(va->length * sizeof(void*));
-    if(!idx) toss(MemoryError);
-    for(size_t i = 0; i < va->length; i++)
-        idx[i] = va->data + i * va->elem_size;
-    va_quick_sort_(idx, va->length, cmp);
-
-    unsigned char* buf = (unsigned char*) malloc(va->length * va->elem_size);
-    if(!buf) toss(MemoryError);
-    for(size_t i = 0; i < va->length; i++)
-        memcpy(buf + i * va->elem_size, idx[i], va->elem_size);
-    memcpy(va->data, buf, va->length * va->elem_size);
-
-    free(buf);
-    free(idx);
+    if(!va->length) return DS_UNDERFLOW;
+    if(pos >= va->length) return DS_OUT_OF_RANGE;
+    va_remove_range(va, pos, 1);
+    return DS_OK;
 }
 
 void va_swap(varray* va, size_t posa, size_t posb)
@@ -123,12 +163,14 @@ void va_swap(varray* va, size_t posa, size_t posb)
     if(posa == posb) return; // disgusting exception
 
     void* t = malloc(va->elem_size);
+    ds_stat_alloc(DS_STAT_VARRAY, va->elem_size);
 
     memcpy(t, va_at(va, posa), va->elem_size);
     memcpy(va_at(va, posa), va_at(va, posb), va->elem_size);
     memcpy(va_at(va, posb), t, va->elem_size);
 
     free(t);
+    ds_stat_free(DS_STAT_VARRAY);
 }
 
 int va_printf(varray* va, const char* fmt, ...)
@@ -140,8 +182,8 @@ int va_printf(varray* va, const char* fmt, ...)
     int total = vsnprintf(NULL, 0, fmt, args);
 
     if(total >= 0) {
-        for(int i = 0; i <= total / va->elem_size; i++)
-            va_append(va, NULL); // append one more block for null-terminator
+        // append one more block for null-terminator
+        va_append_n(va, NULL, total / va->elem_size + 1);
 
         va_start(args, fmt);
         int new_total = vsnprintf((char*)(va->data + len * va->elem_size),
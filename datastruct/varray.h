@@ -7,6 +7,8 @@
 
 #include <stddef.h>
 
+#include "exception.h"
+
 #define INITIAL_ALLOC_SIZE 4
 
 #if INITIAL_ALLOC_SIZE < 1
@@ -20,15 +22,28 @@
  * YOU CAN STORE THE INDEX TO SOLVE THIS PROBLEM.
  */
 
+/*
+ * A growth policy maps current capacity and the required minimum onto the new
+ * capacity, which must be no less than `required`. It's consulted only when the
+ * buffer is really going to be reallocated. The built-in policies saturate at
+ * SIZE_MAX instead of wrapping around.
+ */
+typedef size_t (*va_growth) (size_t capacity, size_t required);
+
 typedef struct varray_t {
     size_t length;
     unsigned char* data;
     size_t capacity;
     int elem_size;
+    va_growth growth;
 } varray;
 
 typedef int (*va_cmp) (void*, void*);
 
+size_t va_growth_double(size_t capacity, size_t required);
+size_t va_growth_golden(size_t capacity, size_t required);
+size_t va_growth_exact(size_t capacity, size_t required);
+
 varray* va_create_(size_t szelem);
 void va_destroy(varray* va);
 size_t va_length(const varray* va);
@@ -37,10 +52,25 @@ void va_insert(varray* va, size_t pos, void* data);
 void va_prepend(varray* va, void* data);
 void va_append(varray* va, void* data);
 void va_remove(varray* va, size_t pos);
+
+/*
+ * Bulk operations reallocate at most once and move the tail by one memmove.
+ * Like va_remove, va_remove_range clamps a `pos` past the end onto the last
+ * element rather than tossing. Growing beyond what size_t can address tosses
+ * MemoryError.
+ */
+void va_reserve(varray* va, size_t capacity);
+void va_set_growth(varray* va, va_growth growth);
+void va_insert_n(varray* va, size_t pos, void* data, size_t count);
+void va_append_n(varray* va, void* data, size_t count);
+void va_remove_range(varray* va, size_t pos, size_t count);
 void va_sort(varray* va, va_cmp cmp);
 void va_swap(varray* va, size_t posa, size_t posb);
 
 void* va_at(varray* va, size_t pos);
+// error code variants of va_at and va_remove, see exception.h
+ds_error va_try_at(varray* va, size_t pos, void** elem);
+ds_error va_try_remove(varray* va, size_t pos);
 int va_printf(varray* va, const char* fmt, ...);
 
 #define va_create(type) va_create_(sizeof(type))
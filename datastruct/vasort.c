@@ -0,0 +1,246 @@
+/*
+ * Copyright(c) 2015, Shihira Fung <fengzhiping@hotmail.com>
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "dsstat.h"
+#include "exception.h"
+#include "utils.h"
+#include "vasort.h"
+
+// partitions shorter than this are left to insertion sort
+#define INSERTION_THRESHOLD 16
+// radix sort is not worth its buffer on arrays shorter than this
+#define RADIX_THRESHOLD 256
+
+#define elem(base, i, sz) ((unsigned char*)(base) + (i) * (sz))
+#define sort_cmp(cmp, a, b) ds_stat_cmp(DS_STAT_VARRAY, cmp, a, b)
+
+static inline void va_swap_elem_(unsigned char* a, unsigned char* b, size_t sz)
+{
+    // constant-sized memcpys get inlined, which matters for the common widths
+    if(sz == 4) {
+        uint32_t t; memcpy(&t, a, 4); memcpy(a, b, 4); memcpy(b, &t, 4);
+    } else if(sz == 8) {
+        uint64_t t; memcpy(&t, a, 8); memcpy(a, b, 8); memcpy(b, &t, 8);
+    } else {
+        unsigned char t[64];
+        for(; sz > sizeof(t); sz -= sizeof(t), a += sizeof(t), b += sizeof(t)) {
+            memcpy(t, a, sizeof(t));
+            memcpy(a, b, sizeof(t));
+            memcpy(b, t, sizeof(t));
+        }
+        memcpy(t, a, sz);
+        memcpy(a, b, sz);
+        memcpy(b, t, sz);
+    }
+}
+
+static void va_insertion_sort_(unsigned char* base, size_t len,
+        size_t sz, va_cmp cmp)
+{
+    for(size_t i = 1; i < len; i++)
+        for(size_t j = i; j > 0 &&
+                sort_cmp(cmp, elem(base, j - 1, sz), elem(base, j, sz)) > 0;
+                j--)
+            va_swap_elem_(elem(base, j - 1, sz), elem(base, j, sz), sz);
+}
+
+static void va_sift_down_(unsigned char* base, size_t i, size_t len,
+        size_t sz, va_cmp cmp)
+{
+    for(size_t c; (c = i * 2 + 1) < len; i = c) {
+        if(c + 1 < len &&
+                sort_cmp(cmp, elem(base, c, sz), elem(base, c + 1, sz)) < 0)
+            c++;
+        if(sort_cmp(cmp, elem(base, i, sz), elem(base, c, sz)) >= 0) break;
+        va_swap_elem_(elem(base, i, sz), elem(base, c, sz), sz);
+    }
+}
+
+static void va_heap_sort_(unsigned char* base, size_t len,
+        size_t sz, va_cmp cmp)
+{
+    for(size_t i = len / 2; i > 0; i--)
+        va_sift_down_(base, i - 1, len, sz, cmp);
+    for(size_t i = len - 1; i > 0; i--) {
+        va_swap_elem_(base, elem(base, i, sz), sz);
+        va_sift_down_(base, 0, i, sz, cmp);
+    }
+}
+
+static void va_introsort_loop_(unsigned char* base, size_t len,
+        size_t sz, va_cmp cmp, int depth)
+{
+    while(len > INSERTION_THRESHOLD) {
+        // quick sort has gone quadratic, fall back to heap sort
+        if(depth-- == 0) {
+            va_heap_sort_(base, len, sz, cmp);
+            return;
+        }
+
+        // median of three, moved to the front as pivot
+        unsigned char *lo = base, *mid = elem(base, len / 2, sz),
+                      *hi = elem(base, len - 1, sz);
+        if(sort_cmp(cmp, mid, lo) < 0) va_swap_elem_(mid, lo, sz);
+        if(sort_cmp(cmp, hi, mid) < 0) va_swap_elem_(hi, mid, sz);
+        if(sort_cmp(cmp, mid, lo) < 0) va_swap_elem_(mid, lo, sz);
+        va_swap_elem_(lo, mid, sz);
+
+        // both scans stop at keys equal to pivot, so that duplicates are
+        // spread evenly to both sides
+        size_t i = 0, j = len;
+        while(1) {
+            do i++;
+            while(i < len && sort_cmp(cmp, elem(base, i, sz), base) < 0);
+            do j--; while(sort_cmp(cmp, elem(base, j, sz), base) > 0);
+            if(i >= j) break;
+            va_swap_elem_(elem(base, i, sz), elem(base, j, sz), sz);
+        }
+        va_swap_elem_(base, elem(base, j, sz), sz);
+
+        // recurse into the smaller side to keep the stack logarithmic
+        if(j < len - j - 1) {
+            va_introsort_loop_(base, j, sz, cmp, depth);
+            base = elem(base, j + 1, sz);
+            len = len - j - 1;
+        } else {
+            va_introsort_loop_(elem(base, j + 1, sz), len - j - 1,
+                    sz, cmp, depth);
+            len = j;
+        }
+    }
+
+    va_insertion_sort_(base, len, sz, cmp);
+}
+
+void va_introsort_(void* base, size_t len, size_t szelem, va_cmp cmp)
+{
+    int depth = 0;
+    for(size_t n = len; n > 1; n /= 2) depth += 2;
+    va_introsort_loop_((unsigned char*)base, len, szelem, cmp, depth);
+}
+
+void va_introsort(varray* va, va_cmp cmp)
+{ va_introsort_(va->data, va->length, va->elem_size, cmp); }
+
+////////////////////////////////////////////////////////////////////////////////
+// Stable Merge Sort
+
+static void va_merge_(unsigned char* dst, unsigned char* l, size_t nl,
+        unsigned char* r, size_t nr, size_t sz, va_cmp cmp)
+{
+    unsigned char *le = elem(l, nl, sz), *re = elem(r, nr, sz);
+
+    while(l < le && r < re) {
+        // take from the left on ties to keep the sort stable
+        if(sort_cmp(cmp, r, l) < 0) { memcpy(dst, r, sz); r += sz; }
+        else { memcpy(dst, l, sz); l += sz; }
+        dst += sz;
+    }
+
+    memcpy(dst, l, le - l); dst += le - l;
+    memcpy(dst, r, re - r);
+}
+
+void va_sort_stable_(void* base, size_t len, size_t szelem, va_cmp cmp)
+{
+    unsigned char* src = (unsigned char*)base;
+
+    for(size_t i = 0; i < len; i += INSERTION_THRESHOLD)
+        va_insertion_sort_(elem(src, i, szelem),
+            len - i < INSERTION_THRESHOLD ? len - i : INSERTION_THRESHOLD,
+            szelem, cmp);
+    if(len <= INSERTION_THRESHOLD) return;
+
+    unsigned char* buf = (unsigned char*) malloc(len * szelem);
+    if(!buf) toss(MemoryError);
+
+    unsigned char* dst = buf;
+    for(size_t run = INSERTION_THRESHOLD; run < len; run *= 2) {
+        for(size_t i = 0; i < len; i += 2 * run) {
+            size_t nl = len - i < run ? len - i : run;
+            size_t nr = len - i - nl < run ? len - i - nl : run;
+            va_merge_(elem(dst, i, szelem), elem(src, i, szelem), nl,
+                elem(src, i + nl, szelem), nr, szelem, cmp);
+        }
+
+        unsigned char* t = src; src = dst; dst = t;
+    }
+
+    if(src != base) memcpy(base, src, len * szelem);
+    free(buf);
+}
+
+void va_sort_stable(varray* va, va_cmp cmp)
+{ va_sort_stable_(va->data, va->length, va->elem_size, cmp); }
+
+////////////////////////////////////////////////////////////////////////////////
+// LSD Radix Sort
+
+/*
+ * Keys are biased by flipping the sign bit so that signed integers compare as
+ * unsigned ones. Histograms of all digits are collected in a single pass, and
+ * the passes where every key shares the same digit are skipped.
+ */
+#define DEF_RADIX_SORT(name, type, utype, nbytes) \
+void name(varray* va) \
+{ \
+    size_t len = va->length; \
+    if(len < RADIX_THRESHOLD) { \
+        va_introsort(va, (va_cmp)(nbytes == 4 ? cmpi : cmpi64)); \
+        return; \
+    } \
+    \
+    const utype bias = (utype)1 << (nbytes * 8 - 1); \
+    utype* src = (utype*)va->data; \
+    utype* dst = (utype*) malloc(len * sizeof(utype)); \
+    if(!dst) toss(MemoryError); \
+    \
+    size_t* hist = (size_t*) calloc(nbytes * 256, sizeof(size_t)); \
+    if(!hist) toss(MemoryError); \
+    for(size_t i = 0; i < len; i++) { \
+        utype k = src[i] ^ bias; \
+        for(int d = 0; d < nbytes; d++) \
+            hist[d * 256 + ((k >> (d * 8)) & 0xff)]++; \
+    } \
+    \
+    for(int d = 0; d < nbytes; d++) { \
+        size_t* h = hist + d * 256; \
+        utype first = ((src[0] ^ bias) >> (d * 8)) & 0xff; \
+        if(h[first] == len) continue; \
+        \
+        size_t sum = 0; \
+        for(int b = 0; b < 256; b++) { \
+            size_t c = h[b]; h[b] = sum; sum += c; \
+        } \
+        for(size_t i = 0; i < len; i++) \
+            dst[h[((src[i] ^ bias) >> (d * 8)) & 0xff]++] = src[i]; \
+        \
+        utype* t = src; src = dst; dst = t; \
+    } \
+    \
+    if(src != (utype*)va->data) { \
+        memcpy(va->data, src, len * sizeof(utype)); \
+        dst = src; \
+    } \
+    free(dst); \
+    free(hist); \
+}
+
+DEF_RADIX_SORT(va_radix_sort_i32, int32_t, uint32_t, 4)
+DEF_RADIX_SORT(va_radix_sort_i64, int64_t, uint64_t, 8)
+
+////////////////////////////////////////////////////////////////////////////////
+
+void va_sort(varray* va, va_cmp cmp)
+{
+    if(cmp == (va_cmp)cmpi && va->elem_size == sizeof(int32_t))
+        va_radix_sort_i32(va);
+    else if(cmp == (va_cmp)cmpi64 && va->elem_size == sizeof(int64_t))
+        va_radix_sort_i64(va);
+    else va_introsort(va, cmp);
+}
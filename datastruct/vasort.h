@@ -0,0 +1,27 @@
+/*
+ * Copyright(c) 2015, Shihira Fung <fengzhiping@hotmail.com>
+ */
+
+#ifndef VASORT_H_INCLUDED
+#define VASORT_H_INCLUDED
+
+// vasort collects sorting algorithms working in place on varray buffers.
+// All of them sort in ascending order judged by cmp, same as va_sort.
+
+#include "varray.h"
+
+/*
+ * va_sort dispatches to the fastest suitable algorithm: when cmp is `cmpi` or
+ * `cmpi64` from utils.h and the element width matches, the keys are sorted by
+ * LSD radix sort, otherwise by introsort.
+ */
+void va_introsort(varray* va, va_cmp cmp);
+void va_sort_stable(varray* va, va_cmp cmp);
+void va_radix_sort_i32(varray* va);
+void va_radix_sort_i64(varray* va);
+
+// raw versions operating on bare buffers, for other sorting front-ends
+void va_introsort_(void* base, size_t len, size_t szelem, va_cmp cmp);
+void va_sort_stable_(void* base, size_t len, size_t szelem, va_cmp cmp);
+
+#endif // VASORT_H_INCLUDED
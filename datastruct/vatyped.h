@@ -0,0 +1,181 @@
+/*
+ * Copyright(c) 2015, Shihira Fung <fengzhiping@hotmail.com>
+ */
+
+#ifndef VATYPED_H_INCLUDED
+#define VATYPED_H_INCLUDED
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "exception.h"
+#include "utils.h"
+
+/*
+ * VA_DEFINE(name, type, cmp) generates a varray specialized for `type`: the
+ * struct `name` and static inline functions name_create, name_destroy,
+ * name_reserve, name_append, name_insert, name_remove, name_at, name_sort and
+ * name_lower_bound. Elements are passed by value, and cmp is a function or a
+ * macro comparing two of them like comparator does, e.g. cmp_num. With element
+ * size and comparison known at compile time, copies and comparisons are
+ * inlined rather than going through memcpy and a function pointer. name_sort
+ * is the same introsort as va_introsort.
+ *
+ *     VA_DEFINE(va_int64, int64_t, cmp_num)
+ *     va_int64* va = va_int64_create();
+ *     va_int64_append(va, 42);
+ */
+
+#define VA_TYPED_INSERTION_THRESHOLD 16
+
+#define VA_DEFINE(name, type, cmp) \
+\
+typedef struct name##_t_ { \
+    size_t length; \
+    size_t capacity; \
+    type* data; \
+} name; \
+\
+static inline name* name##_create(void) \
+{ \
+    name* va = (name*)malloc(sizeof(name)); \
+    if(!va) toss(MemoryError); \
+    va->length = 0; \
+    va->capacity = 0; \
+    va->data = NULL; \
+    return va; \
+} \
+\
+static inline void name##_destroy(name* va) \
+{ \
+    free(va->data); \
+    free(va); \
+} \
+\
+static inline void name##_reserve(name* va, size_t capacity) \
+{ \
+    if(capacity <= va->capacity) return; \
+    type* data = (type*)realloc(va->data, capacity * sizeof(type)); \
+    if(!data) toss(MemoryError); \
+    va->data = data; \
+    va->capacity = capacity; \
+} \
+\
+static inline void name##_grow_(name* va) \
+{ \
+    name##_reserve(va, va->capacity ? va->capacity * 2 : 4); \
+} \
+\
+static inline void name##_append(name* va, type e) \
+{ \
+    if(va->length == va->capacity) name##_grow_(va); \
+    va->data[va->length++] = e; \
+} \
+\
+static inline void name##_insert(name* va, size_t pos, type e) \
+{ \
+    if(pos > va->length) toss(OutOfRange); \
+    if(va->length == va->capacity) name##_grow_(va); \
+    memmove(va->data + pos + 1, va->data + pos, \
+            (va->length - pos) * sizeof(type)); \
+    va->data[pos] = e; \
+    va->length++; \
+} \
+\
+static inline void name##_remove(name* va, size_t pos) \
+{ \
+    if(pos >= va->length) toss(OutOfRange); \
+    memmove(va->data + pos, va->data + pos + 1, \
+            (va->length - pos - 1) * sizeof(type)); \
+    va->length--; \
+} \
+\
+static inline type* name##_at(name* va, size_t pos) \
+{ \
+    if(pos >= va->length) toss(OutOfRange); \
+    return va->data + pos; \
+} \
+\
+static inline void name##_swap_(type* a, type* b) \
+{ \
+    type t = *a; \
+    *a = *b; \
+    *b = t; \
+} \
+\
+static void name##_sift_down_(type* base, size_t i, size_t len) \
+{ \
+    for(size_t c; (c = i * 2 + 1) < len; i = c) { \
+        if(c + 1 < len && cmp(base[c], base[c + 1]) < 0) c++; \
+        if(cmp(base[i], base[c]) >= 0) break; \
+        name##_swap_(base + i, base + c); \
+    } \
+} \
+\
+static void name##_introsort_loop_(type* base, size_t len, int depth) \
+{ \
+    while(len > VA_TYPED_INSERTION_THRESHOLD) { \
+        if(depth-- == 0) { \
+            for(size_t i = len / 2; i > 0; i--) \
+                name##_sift_down_(base, i - 1, len); \
+            for(size_t i = len - 1; i > 0; i--) { \
+                name##_swap_(base, base + i); \
+                name##_sift_down_(base, 0, i); \
+            } \
+            return; \
+        } \
+\
+        type *lo = base, *mid = base + len / 2, *hi = base + len - 1; \
+        if(cmp(*mid, *lo) < 0) name##_swap_(mid, lo); \
+        if(cmp(*hi, *mid) < 0) name##_swap_(hi, mid); \
+        if(cmp(*mid, *lo) < 0) name##_swap_(mid, lo); \
+        name##_swap_(lo, mid); \
+\
+        size_t i = 0, j = len; \
+        while(1) { \
+            do i++; while(i < len && cmp(base[i], base[0]) < 0); \
+            do j--; while(cmp(base[j], base[0]) > 0); \
+            if(i >= j) break; \
+            name##_swap_(base + i, base + j); \
+        } \
+        name##_swap_(base, base + j); \
+\
+        if(j < len - j - 1) { \
+            name##_introsort_loop_(base, j, depth); \
+            base += j + 1; \
+            len -= j + 1; \
+        } else { \
+            name##_introsort_loop_(base + j + 1, len - j - 1, depth); \
+            len = j; \
+        } \
+    } \
+\
+    for(size_t i = 1; i < len; i++) { \
+        type e = base[i]; \
+        size_t j = i; \
+        for(; j > 0 && cmp(base[j - 1], e) > 0; j--) \
+            base[j] = base[j - 1]; \
+        base[j] = e; \
+    } \
+} \
+\
+static inline void name##_sort(name* va) \
+{ \
+    int depth = 0; \
+    for(size_t n = va->length; n > 1; n /= 2) depth += 2; \
+    name##_introsort_loop_(va->data, va->length, depth); \
+} \
+\
+/* index of the first element not less than e, in a sorted array */ \
+static inline size_t name##_lower_bound(name* va, type e) \
+{ \
+    size_t lo = 0, hi = va->length; \
+    while(lo < hi) { \
+        size_t mid = lo + (hi - lo) / 2; \
+        if(cmp(va->data[mid], e) < 0) lo = mid + 1; \
+        else hi = mid; \
+    } \
+    return lo; \
+}
+
+#endif // VATYPED_H_INCLUDED